@@ -0,0 +1,349 @@
+// Arrangement cost of FlexLayout<Axis> against the HorizontalLayout /
+// VerticalLayout classes it replaced, on identical trees.
+//
+//   make bench
+//
+// The legacy classes below are the pre-FlexLayout ones: the same measuring
+// and placing, but the per-child loops branch on axis, justify and align at
+// runtime. Both variants arrange the same children (already measured) many
+// times; the wrap cache is invalidated before each pass so wrapping
+// containers re-break every line, like the legacy classes did.
+#include "../headers/container.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+// -------------------------------------------------------------
+// Legacy kernels (runtime branching)
+// -------------------------------------------------------------
+
+namespace LegacyFlex {
+
+static float mainOf(const sf::Vector2f &v, Axis axis) {
+  return axis == Axis::Horizontal ? v.x : v.y;
+}
+
+static float crossOf(const sf::Vector2f &v, Axis axis) {
+  return axis == Axis::Horizontal ? v.y : v.x;
+}
+
+static sf::Vector2f toPoint(const FlexParams &params, float main,
+                            float cross) {
+  return params.mainAxis == Axis::Horizontal
+             ? sf::Vector2f(params.origin.x + main, params.origin.y + cross)
+             : sf::Vector2f(params.origin.x + cross, params.origin.y + main);
+}
+
+static void justify(JustifyContent mode, float extraSpace, std::size_t count,
+                    float gap, float &startOffset, float &itemGap) {
+  const float n = static_cast<float>(count);
+  startOffset = 0.0f;
+  itemGap = gap;
+
+  switch (mode) {
+  case JustifyContent::Center:
+    startOffset = extraSpace / 2.0f;
+    break;
+  case JustifyContent::End:
+    startOffset = extraSpace;
+    break;
+  case JustifyContent::SpaceBetween:
+    if (count > 1)
+      itemGap += extraSpace / (n - 1.0f);
+    break;
+  case JustifyContent::SpaceAround:
+    itemGap += extraSpace / n;
+    startOffset = extraSpace / n / 2.0f;
+    break;
+  case JustifyContent::SpaceEvenly:
+    itemGap += extraSpace / (n + 1.0f);
+    startOffset = extraSpace / (n + 1.0f);
+    break;
+  default:
+    break;
+  }
+}
+
+static float align(AlignItems mode, float space, float size) {
+  switch (mode) {
+  case AlignItems::Center:
+    return (space - size) / 2.0f;
+  case AlignItems::End:
+    return space - size;
+  default:
+    return 0.0f;
+  }
+}
+
+static void arrangeLine(const sf::Vector2f *sizes, std::size_t count,
+                        const FlexParams &params, sf::Vector2f *positions) {
+  if (count == 0)
+    return;
+
+  float total = 0.0f;
+  for (std::size_t i = 0; i < count; ++i)
+    total += mainOf(sizes[i], params.mainAxis);
+  total += params.gap * (count - 1);
+
+  float startOffset, itemGap;
+  justify(params.justify, params.mainLimit - total, count, params.gap,
+          startOffset, itemGap);
+
+  float main = std::max(0.0f, startOffset);
+  for (std::size_t i = 0; i < count; ++i) {
+    float cross = align(params.align, params.crossLimit,
+                        crossOf(sizes[i], params.mainAxis));
+    positions[i] = toPoint(params, main, cross);
+    main += mainOf(sizes[i], params.mainAxis) + itemGap;
+  }
+}
+
+static void breakLines(const sf::Vector2f *sizes, std::size_t count,
+                       const FlexParams &params,
+                       std::vector<WrapLine> &lines) {
+  std::size_t i = 0;
+  float crossOffset = 0.0f;
+  while (i < count) {
+    WrapLine line;
+    line.start = i;
+    line.crossOffset = crossOffset;
+
+    while (i < count) {
+      float main = mainOf(sizes[i], params.mainAxis);
+      float extent =
+          line.count == 0 ? main : line.mainExtent + params.gap + main;
+      if (line.count > 0 && extent > params.mainLimit)
+        break;
+
+      line.mainExtent = extent;
+      line.crossExtent =
+          std::max(line.crossExtent, crossOf(sizes[i], params.mainAxis));
+      ++line.count;
+      ++i;
+    }
+
+    lines.push_back(line);
+    crossOffset += line.crossExtent + params.gap;
+  }
+}
+
+static void arrangeWrappedLine(const WrapLine &line, const sf::Vector2f *sizes,
+                               const FlexParams &params,
+                               sf::Vector2f *positions) {
+  float startOffset, itemGap;
+  justify(params.justify, std::max(0.0f, params.mainLimit - line.mainExtent),
+          line.count, params.gap, startOffset, itemGap);
+
+  float main = startOffset;
+  for (std::size_t i = line.start; i < line.start + line.count; ++i) {
+    float cross = line.crossOffset + align(params.align, line.crossExtent,
+                                           crossOf(sizes[i], params.mainAxis));
+    positions[i] = toPoint(params, main, cross);
+    main += mainOf(sizes[i], params.mainAxis) + itemGap;
+  }
+}
+
+} // namespace LegacyFlex
+
+// -------------------------------------------------------------
+// Layout classes under test
+// -------------------------------------------------------------
+
+// Shared by both variants: the layout properties and how they are set
+struct BenchConfig {
+  Axis axis = Axis::Horizontal;
+  JustifyContent justify = JustifyContent::Start;
+  AlignItems align = AlignItems::Start;
+  WrapMode wrap = WrapMode::NoWrap;
+  float gap = 4.0f;
+};
+
+// HorizontalLayout / VerticalLayout before FlexLayout<Axis>
+class LegacyLayout : public Container {
+public:
+  LegacyLayout(sf::RenderWindow &window, const BenchConfig &config)
+      : Container(window), config(config) {}
+
+  void drawSelf() override {}
+
+  void arrangeChildren() override {
+    const sf::Vector2f content = getContentSize();
+    const bool horizontal = config.axis == Axis::Horizontal;
+    const FlexParams params = {config.axis,
+                               {computedPosition.x + boxModel.padding[3],
+                                computedPosition.y + boxModel.padding[0]},
+                               horizontal ? content.x : content.y,
+                               horizontal ? content.y : content.x,
+                               config.gap,
+                               config.justify,
+                               config.align};
+
+    const std::size_t count = children.size();
+    layoutSizes.resize(count);
+    layoutPositions.resize(count);
+    for (std::size_t i = 0; i < count; ++i)
+      layoutSizes[i] = measureChild(*children[i]);
+
+    if (config.wrap == WrapMode::Wrap) {
+      lines.clear();
+      LegacyFlex::breakLines(layoutSizes.data(), count, params, lines);
+      for (const WrapLine &line : lines)
+        LegacyFlex::arrangeWrappedLine(line, layoutSizes.data(), params,
+                                       layoutPositions.data());
+    } else {
+      LegacyFlex::arrangeLine(layoutSizes.data(), count, params,
+                              layoutPositions.data());
+    }
+    for (std::size_t i = 0; i < count; ++i)
+      placeChild(*children[i], layoutPositions[i]);
+  }
+
+  void rearrange() { arrangeChildren(); }
+
+private:
+  BenchConfig config;
+  std::vector<WrapLine> lines;
+};
+
+// FlexLayout<Axis>, with the wrap cache emptied before each pass
+template <Axis MainAxis> class BenchFlexLayout : public FlexLayout<MainAxis> {
+public:
+  BenchFlexLayout(sf::RenderWindow &window, const BenchConfig &config)
+      : FlexLayout<MainAxis>(window) {
+    this->justifyContent = config.justify;
+    this->alignItems = config.align;
+    this->wrap = config.wrap;
+    this->gap = config.gap;
+  }
+
+  void rearrange() {
+    this->wrapCache.invalidateFrom(0);
+    this->arrangeChildren();
+  }
+};
+
+// -------------------------------------------------------------
+// Benchmark
+// -------------------------------------------------------------
+
+static const std::size_t childCount = 1000;
+static const int passes = 2000;
+static const int runs = 5;
+
+static StyleRef childStyle(std::size_t i) {
+  Styles styles;
+  styles.width = std::to_string(10 + i % 17) + "px";
+  styles.height = std::to_string(8 + i % 11) + "px";
+  return StyleRef(styles);
+}
+
+// Root with `childCount` children, laid out once so every child is measured
+template <typename Layout>
+static std::shared_ptr<Layout> buildTree(sf::RenderWindow &window,
+                                         const BenchConfig &config) {
+  auto root = std::make_shared<Layout>(window, config);
+  Styles styles;
+  styles.width = "1200px";
+  styles.height = "800px";
+  styles.padding[0] = styles.padding[3] = "5px";
+  root->setStyle(StyleRef(styles));
+  std::vector<Container::Ptr> items;
+  for (std::size_t i = 0; i < childCount; ++i) {
+    auto child = std::make_shared<LegacyLayout>(window, BenchConfig());
+    child->setStyle(childStyle(i));
+    items.push_back(child);
+  }
+  root->insertChildren(0, items);
+  root->layout();
+  return root;
+}
+
+// Best of `runs`, in nanoseconds per child
+template <typename Layout> static double timeArrange(Layout &root) {
+  double best = 1e30;
+  for (int run = 0; run < runs; ++run) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < passes; ++pass)
+      root.rearrange();
+    const std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+    best = std::min(best, elapsed.count() / (passes * double(childCount)));
+  }
+  return best;
+}
+
+static bool samePositions(const Container &a, const Container &b) {
+  for (std::size_t i = 0; i < a.getChildren().size(); ++i) {
+    if (a.getChildren()[i]->computedPosition !=
+        b.getChildren()[i]->computedPosition)
+      return false;
+  }
+  return true;
+}
+
+template <Axis MainAxis>
+static bool benchAxis(sf::RenderWindow &window, const char *axisName,
+                      double &legacyTotal, double &flexTotal, int &cases) {
+  static const char *justifyNames[] = {"start",   "center", "end",
+                                       "between", "around", "evenly"};
+  static const char *alignNames[] = {"start", "center", "end"};
+
+  bool ok = true;
+  for (int wrap = 0; wrap < 2; ++wrap) {
+    for (int j = 0; j < 6; ++j) {
+      for (int a = 0; a < 3; ++a) {
+        BenchConfig config;
+        config.axis = MainAxis;
+        config.justify = static_cast<JustifyContent>(j);
+        config.align = static_cast<AlignItems>(a);
+        config.wrap = wrap ? WrapMode::Wrap : WrapMode::NoWrap;
+
+        auto legacy = buildTree<LegacyLayout>(window, config);
+        auto flex = buildTree<BenchFlexLayout<MainAxis>>(window, config);
+        if (!samePositions(*legacy, *flex)) {
+          std::printf("MISMATCH %s %s %s %s\n", axisName,
+                      wrap ? "wrap" : "nowrap", justifyNames[j],
+                      alignNames[a]);
+          ok = false;
+        }
+
+        const double legacyNs = timeArrange(*legacy);
+        const double flexNs = timeArrange(*flex);
+        legacyTotal += legacyNs;
+        flexTotal += flexNs;
+        ++cases;
+        std::printf("%-10s %-6s %-7s %-6s %8.2f %8.2f %7.2fx\n", axisName,
+                    wrap ? "wrap" : "nowrap", justifyNames[j], alignNames[a],
+                    legacyNs, flexNs, legacyNs / flexNs);
+      }
+    }
+  }
+  return ok;
+}
+
+int main() {
+  // Nothing is drawn, and viewport units are not used by the trees
+  sf::RenderWindow window;
+
+  std::printf("%zu children, best of %d x %d passes, ns per child\n",
+              childCount, runs, passes);
+  std::printf("%-10s %-6s %-7s %-6s %8s %8s %8s\n", "axis", "wrap",
+              "justify", "align", "legacy", "flex", "speedup");
+
+  double legacyTotal = 0.0, flexTotal = 0.0;
+  int cases = 0;
+  bool ok = benchAxis<Axis::Horizontal>(window, "horizontal", legacyTotal,
+                                        flexTotal, cases);
+  ok = benchAxis<Axis::Vertical>(window, "vertical", legacyTotal, flexTotal,
+                                 cases) &&
+       ok;
+
+  std::printf("mean over %d cases: legacy %.2f ns, flex %.2f ns (%.2fx)\n",
+              cases, legacyTotal / cases, flexTotal / cases,
+              legacyTotal / flexTotal);
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,199 @@
+#include "../headers/animator.hpp"
+#include <algorithm>
+
+static float ease(Easing easing, float t) {
+  switch (easing) {
+  case Easing::EaseIn:
+    return t * t;
+  case Easing::EaseOut:
+    return t * (2.0f - t);
+  case Easing::EaseInOut:
+    return t < 0.5f ? 2.0f * t * t : -1.0f + (4.0f - 2.0f * t) * t;
+  default:
+    return t;
+  }
+}
+
+static std::array<float, 4> scalar(float v) { return {v, 0.0f, 0.0f, 0.0f}; }
+
+static std::array<float, 4> rgba(const sf::Color &c) {
+  return {static_cast<float>(c.r), static_cast<float>(c.g),
+          static_cast<float>(c.b), static_cast<float>(c.a)};
+}
+
+static sf::Uint8 channel(float v) {
+  return static_cast<sf::Uint8>(std::max(0.0f, std::min(255.0f, v + 0.5f)));
+}
+
+std::array<float, 4> Animator::currentValue(const Element &element,
+                                            AnimatedProperty property) {
+  switch (property) {
+  case AnimatedProperty::TranslateX:
+    return scalar(element.compositing.translate.x);
+  case AnimatedProperty::TranslateY:
+    return scalar(element.compositing.translate.y);
+  case AnimatedProperty::Opacity:
+    return scalar(element.compositing.opacity);
+  case AnimatedProperty::BackgroundColor:
+    return rgba(element.getBackgroundColor());
+  }
+  return {};
+}
+
+void Animator::apply(Element &element, AnimatedProperty property,
+                     const std::array<float, 4> &value) {
+  Compositing &c = element.compositing;
+  switch (property) {
+  case AnimatedProperty::TranslateX:
+    c.translate.x = value[0];
+    break;
+  case AnimatedProperty::TranslateY:
+    c.translate.y = value[0];
+    break;
+  case AnimatedProperty::Opacity:
+    c.opacity = std::max(0.0f, std::min(1.0f, value[0]));
+    break;
+  case AnimatedProperty::BackgroundColor:
+    c.overrideBackground = true;
+    c.backgroundColor = sf::Color(channel(value[0]), channel(value[1]),
+                                  channel(value[2]), channel(value[3]));
+    break;
+  }
+}
+
+Animator::Id Animator::start(Animation animation) {
+  animation.id = nextId++;
+  animation.elapsed = -animation.options.delay;
+  animations.push_back(animation);
+  return animation.id;
+}
+
+Animator::Id Animator::animate(const std::shared_ptr<Element> &target,
+                               AnimatedProperty property, float from, float to,
+                               float duration, Options options) {
+  // One lane would animate towards (r, 0, 0, 0): transparent black
+  if (property == AnimatedProperty::BackgroundColor)
+    return 0;
+
+  Animation animation;
+  animation.target = target;
+  animation.property = property;
+  animation.from = scalar(from);
+  animation.to = scalar(to);
+  animation.duration = duration;
+  animation.options = options;
+  return start(animation);
+}
+
+Animator::Id Animator::animateColor(const std::shared_ptr<Element> &target,
+                                    sf::Color from, sf::Color to,
+                                    float duration, Options options) {
+  Animation animation;
+  animation.target = target;
+  animation.property = AnimatedProperty::BackgroundColor;
+  animation.from = rgba(from);
+  animation.to = rgba(to);
+  animation.duration = duration;
+  animation.options = options;
+  return start(animation);
+}
+
+Animator::Id Animator::transition(const std::shared_ptr<Element> &target,
+                                  AnimatedProperty property, float to,
+                                  float duration, Easing easing) {
+  if (property == AnimatedProperty::BackgroundColor)
+    return 0;
+
+  cancelProperty(target.get(), property);
+  Options options;
+  options.easing = easing;
+  return animate(target, property, currentValue(*target, property)[0], to,
+                 duration, options);
+}
+
+Animator::Id Animator::transitionColor(const std::shared_ptr<Element> &target,
+                                       sf::Color to, float duration,
+                                       Easing easing) {
+  cancelProperty(target.get(), AnimatedProperty::BackgroundColor);
+  Options options;
+  options.easing = easing;
+  return animateColor(target, target->getBackgroundColor(), to, duration,
+                      options);
+}
+
+void Animator::cancel(Id id) {
+  animations.erase(std::remove_if(animations.begin(), animations.end(),
+                                  [id](const Animation &a) {
+                                    return a.id == id;
+                                  }),
+                   animations.end());
+}
+
+void Animator::cancelAll(const Element *target) {
+  animations.erase(std::remove_if(animations.begin(), animations.end(),
+                                  [target](const Animation &a) {
+                                    return a.target.lock().get() == target;
+                                  }),
+                   animations.end());
+}
+
+void Animator::cancelProperty(const Element *target,
+                              AnimatedProperty property) {
+  animations.erase(std::remove_if(animations.begin(), animations.end(),
+                                  [&](const Animation &a) {
+                                    return a.property == property &&
+                                           a.target.lock().get() == target;
+                                  }),
+                   animations.end());
+}
+
+bool Animator::tick(float dt) {
+  bool changed = false;
+
+  // One pass over the flat list; finished animations are compacted away
+  std::size_t write = 0;
+  auto keep = [&](std::size_t read) {
+    if (write != read)
+      animations[write] = std::move(animations[read]);
+    ++write;
+  };
+  for (std::size_t read = 0; read < animations.size(); ++read) {
+    Animation &a = animations[read];
+    std::shared_ptr<Element> target = a.target.lock();
+    if (!target)
+      continue; // element was destroyed
+
+    a.elapsed += dt;
+    if (a.elapsed < 0.0f) {
+      keep(read); // still delayed
+      continue;
+    }
+
+    // Iteration and progress within it
+    float t = a.duration > 0.0f ? a.elapsed / a.duration : 1.0f;
+    int iteration = static_cast<int>(t);
+    bool finished = a.options.repeat >= 0 && iteration > a.options.repeat;
+    if (finished) {
+      iteration = a.options.repeat;
+      t = 1.0f;
+    } else {
+      t -= static_cast<float>(iteration);
+    }
+    if (a.options.alternate && iteration % 2 == 1)
+      t = 1.0f - t;
+
+    const float k = ease(a.options.easing, t);
+    std::array<float, 4> value;
+    for (int i = 0; i < 4; ++i)
+      value[i] = a.from[i] + (a.to[i] - a.from[i]) * k;
+
+    apply(*target, a.property, value);
+    changed = true;
+
+    if (!finished)
+      keep(read);
+  }
+  animations.resize(write);
+
+  return changed;
+}
@@ -0,0 +1,263 @@
+#include "../headers/application.hpp"
+#include "../headers/alloc_guard.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+// How often input is polled while sleeping towards a timer (SFML 2 has no
+// waitEvent with a timeout)
+static const sf::Time inputPollSlice = sf::milliseconds(10);
+
+Application::Application(sf::RenderWindow &window, Container &root)
+    : window(window), root(root), windowBackend(window), input(root) {
+  scheduler.attach(root);
+}
+
+void Application::setLayoutMode(LayoutMode mode) {
+  if (mode == getLayoutMode())
+    return;
+  if (mode == LayoutMode::Pipelined) {
+    pipeline.reset(new LayoutPipeline(root));
+  } else {
+    pipeline->flush(); // nothing may be left half-applied
+    pipeline.reset();
+  }
+  layoutFlushed = false;
+}
+
+// -------------------------------------------------------------
+// Timers
+// -------------------------------------------------------------
+
+Application::TimerId Application::addTimer(sf::Time delay, sf::Time interval,
+                                           std::function<void()> callback) {
+  Timer timer;
+  timer.id = nextTimerId++;
+  timer.due = clock.getElapsedTime() + delay;
+  timer.interval = interval;
+  timer.callback = std::move(callback);
+  timers.push_back(std::move(timer));
+  return timers.back().id;
+}
+
+Application::TimerId Application::setTimeout(sf::Time delay,
+                                             std::function<void()> callback) {
+  return addTimer(delay, sf::Time::Zero, std::move(callback));
+}
+
+Application::TimerId Application::setInterval(sf::Time delay,
+                                              std::function<void()> callback) {
+  return addTimer(delay, delay, std::move(callback));
+}
+
+void Application::cancelTimer(TimerId id) {
+  timers.erase(std::remove_if(timers.begin(), timers.end(),
+                              [id](const Timer &t) { return t.id == id; }),
+               timers.end());
+}
+
+void Application::runTimers() {
+  const sf::Time now = clock.getElapsedTime();
+  for (std::size_t i = 0; i < timers.size();) {
+    if (timers[i].due > now) {
+      ++i;
+      continue;
+    }
+
+    // Callbacks may add or cancel timers, so run a copy
+    std::function<void()> callback = timers[i].callback;
+    if (timers[i].interval > sf::Time::Zero) {
+      // Skip missed ticks instead of firing them in a burst
+      timers[i].due = std::max(timers[i].due + timers[i].interval,
+                               now + sf::microseconds(1));
+      ++i;
+    } else {
+      timers.erase(timers.begin() + i);
+    }
+    callback();
+  }
+}
+
+// -------------------------------------------------------------
+// Loop
+// -------------------------------------------------------------
+
+bool Application::hasWork() const {
+  return redrawRequested || frameRequested || animator.isAnimating() ||
+         root.needsLayout() || scheduler.hasWork() || !mutations.empty();
+}
+
+void Application::run() {
+  while (step()) {
+  }
+}
+
+bool Application::step() {
+  if (!window.isOpen())
+    return false;
+
+  const sf::Time idleStart = clock.getElapsedTime();
+  sf::Event event;
+  const bool woken = waitForWork(event);
+  const sf::Time activeStart = clock.getElapsedTime();
+  stats.idle += activeStart - idleStart;
+  ++stats.wakeups;
+
+  // ---------- Input (coalesced, one dispatch per frame), then timers ----
+  if (woken)
+    handleEvent(event);
+  while (window.pollEvent(event))
+    handleEvent(event);
+  if (input.hasPending() &&
+      input.flush([this](const sf::Event &e) { windowEvent(e); }))
+    redrawRequested = true;
+  runTimers();
+
+  // ---------- Changes queued by other threads, in one batch ----------
+  if (mutations.drain() > 0)
+    redrawRequested = true;
+
+  // ---------- Layout + repaint, only if something changed ----------
+  if (window.isOpen() && hasWork())
+    frame();
+
+  stats.active += clock.getElapsedTime() - activeStart;
+  return window.isOpen();
+}
+
+bool Application::waitForWork(sf::Event &event) {
+  if (hasWork()) {
+    // Animations (and frames waiting for the layout worker) run at the
+    // frame pace, not as fast as the loop can spin
+    if (animator.isAnimating() || frameRequested ||
+        (pipeline && pipeline->busy())) {
+      const sf::Time next = lastFrame + frameInterval;
+      const sf::Time now = clock.getElapsedTime();
+      if (next > now)
+        sf::sleep(next - now);
+    }
+    return false;
+  }
+
+  // Nothing scheduled: block until the OS delivers input. Other threads
+  // cannot wake waitEvent(), so once the queue has been pushed to the loop
+  // polls instead: every inputPollSlice while changes keep coming, every
+  // mutationLatency once they have stopped for mutationPollTime
+  const sf::Time start = clock.getElapsedTime();
+  if (mutations.pushCount() != mutationsSeen) {
+    mutationsSeen = mutations.pushCount();
+    lastMutation = start;
+  }
+  const bool producers = mutationsSeen > 0;
+  const bool recent = producers && start - lastMutation < mutationPollTime;
+  if (timers.empty() && maxIdleWait == sf::Time::Zero && !producers)
+    return window.waitEvent(event);
+
+  // Sleep towards the next timer (or the idle cap), still reacting to input
+  bool limited = maxIdleWait > sf::Time::Zero;
+  sf::Time deadline = start + maxIdleWait;
+  for (const Timer &timer : timers) {
+    if (!limited || timer.due < deadline) {
+      deadline = timer.due;
+      limited = true;
+    }
+  }
+  if (recent && (!limited || lastMutation + mutationPollTime < deadline)) {
+    deadline = lastMutation + mutationPollTime;
+    limited = true;
+  }
+  // Timers and the idle cap already need the fine slice
+  const sf::Time slice = producers && !recent && timers.empty() &&
+                                 maxIdleWait == sf::Time::Zero
+                             ? std::max(mutationLatency, inputPollSlice)
+                             : inputPollSlice;
+
+  for (sf::Time now = clock.getElapsedTime(); !limited || now < deadline;
+       now = clock.getElapsedTime()) {
+    if (window.pollEvent(event))
+      return true;
+    if (producers && mutations.pushCount() != mutationsSeen)
+      return false;
+    sf::sleep(limited ? std::min(slice, deadline - now) : slice);
+  }
+  return false;
+}
+
+void Application::handleEvent(const sf::Event &event) {
+  if (event.type == sf::Event::Closed) {
+    window.close();
+    if (onEvent)
+      onEvent(event);
+    return;
+  }
+  input.push(event);
+}
+
+void Application::windowEvent(const sf::Event &event) {
+  switch (event.type) {
+  case sf::Event::Resized:
+    // The scheduler only lays out a tree that needs it; the root notices
+    // the new viewport when it is measured again
+    root.invalidateLayout();
+    redrawRequested = true;
+    recorder.invalidate();
+    break;
+  case sf::Event::GainedFocus:
+    // The window contents must be painted again
+    redrawRequested = true;
+    recorder.invalidate();
+    break;
+  default:
+    break;
+  }
+
+  if (onEvent)
+    onEvent(event);
+}
+
+void Application::frame() {
+  const sf::Time now = clock.getElapsedTime();
+  // After an idle period the first animated frame starts from zero
+  const float dt = animating ? (now - lastFrame).asSeconds() : 0.0f;
+  lastFrame = now;
+
+  // Steady state: nothing to lay out, animate or run as a job, only record
+  // and compare. Once the buffers have grown during the first frames, such
+  // a frame must not touch the heap
+  const bool steady = !animator.isAnimating() && !scheduler.hasWork() &&
+                      stats.frames + stats.skippedFrames >= 2;
+  const AllocationScope allocations;
+
+  animating = animator.isAnimating();
+  if (animating)
+    animator.tick(dt);
+  redrawRequested = false;
+
+  // The first frame shows a complete layout, however long it takes
+  if (pipeline && !layoutFlushed)
+    pipeline->flush();
+  layoutFlushed = true;
+
+  // Layout and deferred jobs up to the frame budget; the rest of a large
+  // change is finished by the next frames
+  scheduler.runFrame();
+
+  // A window never keeps the previous frame, so replay it whole
+  const bool skipped =
+      recorder.present(windowBackend, root, renderer, clearColor, false) ==
+      FrameRecorder::Result::Skipped;
+  frameRequested = renderer.takeFrameRequest();
+
+  if (AllocGuard::enabled() && steady && allocations.allocations() > 0) {
+    std::cerr << "Error: steady-state frame made "
+              << allocations.allocations() << " heap allocation(s)\n";
+    std::abort();
+  }
+
+  if (skipped) {
+    ++stats.skippedFrames;
+    return;
+  }
+  window.display();
+  ++stats.frames;
+}
@@ -1,7 +1,890 @@
 #include "../headers/container.hpp"
+#include "../headers/frame_scheduler.hpp"
+#include "../headers/stylesheet.hpp"
+#include <typeinfo>
 
 Container::Container(sf::RenderWindow& window)
     : Element(window) { // call base constructor
     // You can initialize layout-specific defaults here
 }
 
+Container::~Container() {
+  // The elements are going away: nothing to restore, only forget them
+  if (stylesheet)
+    stylesheet->root = nullptr;
+  if (scheduler)
+    scheduler->root = nullptr;
+
+  // Children held elsewhere (e.g. by a handler being dispatched) outlive
+  // us: they must not keep pointing here
+  for (auto &ch : children) {
+    if (ch->getParent() == this)
+      ch->setParent(nullptr);
+  }
+}
+
+// -------------------------------------------------------------
+// WrapCache
+// -------------------------------------------------------------
+
+static float mainOf(const sf::Vector2f &v, Axis axis) {
+  return axis == Axis::Horizontal ? v.x : v.y;
+}
+
+std::size_t WrapCache::lineOf(std::size_t child) const {
+  // First line whose start lies after `child`, minus one
+  auto it = std::upper_bound(lines.begin(), lines.end(), child,
+                             [](std::size_t index, const WrapLine &line) {
+                               return index < line.start;
+                             });
+  if (it == lines.begin())
+    return 0;
+  return static_cast<std::size_t>(it - lines.begin()) - 1;
+}
+
+std::size_t WrapCache::firstChangedLine(float mainLimit, float gap) const {
+  for (std::size_t i = 0; i < lines.size(); ++i) {
+    const WrapLine &line = lines[i];
+
+    // Line no longer fits (a single oversized child stays on its own line)
+    if (line.count > 1 && line.mainExtent > mainLimit)
+      return i;
+
+    // The first child of the next line would now fit on this one
+    if (i + 1 < lines.size()) {
+      std::size_t next = lines[i + 1].start;
+      if (next >= sizes.size())
+        return i;
+      float nextMain = mainOf(sizes[next], last.mainAxis);
+      if (line.mainExtent + gap + nextMain <= mainLimit)
+        return i;
+    }
+  }
+  return lines.size();
+}
+
+void WrapCache::breakLinesFrom(std::size_t line, const FlexParams &params) {
+  std::size_t begin = line < lines.size() ? lines[line].start : 0;
+  float cross = 0.0f;
+  if (line > 0) {
+    const WrapLine &prev = lines[line - 1];
+    cross = prev.crossOffset + prev.crossExtent + params.gap;
+  }
+  lines.resize(line);
+  Flex::breakLines(sizes.data(), begin, sizes.size(), params, cross, lines);
+}
+
+void WrapCache::positionLinesFrom(std::size_t line, Container &owner,
+                                  const FlexParams &params) {
+  positions.resize(sizes.size());
+  for (std::size_t l = line; l < lines.size(); ++l) {
+    const WrapLine &wl = lines[l];
+    Flex::arrangeWrappedLine(wl, sizes.data(), params, positions.data());
+    for (std::size_t i = wl.start; i < wl.start + wl.count; ++i)
+      owner.placeChild(*owner.children[i], positions[i]);
+  }
+}
+
+void WrapCache::arrange(Container &owner, const FlexParams &params) {
+  const auto &children = owner.children;
+  const std::size_t count = children.size();
+  std::size_t dirty = std::min(firstDirty, std::min(sizes.size(), count));
+
+  // ---------- Measure: only children at or after an invalidation ----------
+  sizes.resize(count);
+  for (std::size_t i = dirty; i < count; ++i)
+    sizes[i] = owner.measureChild(*children[i]);
+  firstDirty = npos;
+
+  if (count == 0) {
+    lines.clear();
+    hasParams = false;
+    return;
+  }
+
+  const bool sameAxis = hasParams && params.mainAxis == last.mainAxis &&
+                        params.gap == last.gap;
+  // Justification depends on the free space of every line
+  const bool samePlacement =
+      sameAxis && params.origin == last.origin &&
+      params.justify == last.justify && params.align == last.align &&
+      (params.mainLimit == last.mainLimit ||
+       params.justify == JustifyContent::Start);
+
+  // ---------- Find the first line whose break may change ----------
+  std::size_t line = 0;
+  if (sameAxis) {
+    line = lines.size();
+    if (dirty < count) {
+      line = std::min(lineOf(dirty), lines.size());
+      // A child starting a line may now fit on the previous one
+      if (line > 0 && (line == lines.size() || lines[line].start == dirty))
+        --line;
+    }
+    if (params.mainLimit != last.mainLimit)
+      line = std::min(line, firstChangedLine(params.mainLimit, params.gap));
+  }
+
+  std::size_t reposition = samePlacement ? line : 0;
+  if (line < lines.size() || !sameAxis)
+    breakLinesFrom(line, params);
+
+  last = params;
+  hasParams = true;
+  positionLinesFrom(reposition, owner, params);
+}
+
+// -------------------------------------------------------------
+// Invalidation and layout
+// -------------------------------------------------------------
+
+Container *Container::getRoot() {
+  Container *root = this;
+  while (root->parent)
+    root = root->parent;
+  return root;
+}
+
+void Container::markLayoutDirty() {
+  arrangeDirty = true;
+  Element::markLayoutDirty();
+}
+
+void Container::invalidateChildrenFrom(std::size_t first) {
+  arrangeDirty = true;
+  wrapCache.invalidateFrom(first);
+  for (Container *p = parent; p && !p->subtreeDirty; p = p->parent)
+    p->subtreeDirty = true;
+}
+
+void Container::invalidateArrangement(bool resized) {
+  arrangeDirty = true;
+  if (!resized)
+    return;
+
+  // Percentage units of the children resolve against this box
+  for (auto &ch : children)
+    ch->layoutDirty = true;
+  wrapCache.invalidateFrom(0);
+}
+
+void Container::invalidateSubtree() {
+  invalidateArrangement(true);
+  subtreeDirty = true;
+  for (auto &ch : children) {
+    if (auto *container = dynamic_cast<Container *>(ch.get()))
+      container->invalidateSubtree();
+  }
+}
+
+void Container::sortDrawOrder(std::size_t first, std::size_t last) {
+  // Sort a separate draw order by relZIndex for local stacking, so the
+  // layout order of `children` (and the wrap cache built on it) is kept.
+  // Insertion sort is stable without std::stable_sort's temporary buffer,
+  // and linear for the usual (nearly) sorted case
+  drawOrder.clear();
+  for (std::size_t c = first; c < last; ++c) {
+    Element *e = children[c].get();
+    std::size_t i = drawOrder.size();
+    drawOrder.push_back(e);
+    for (; i > 0 && drawOrder[i - 1]->style->relZIndex > e->style->relZIndex;
+         --i)
+      drawOrder[i] = drawOrder[i - 1];
+    drawOrder[i] = e;
+  }
+}
+
+sf::Vector2f Container::measureChild(Element &child) {
+  if (!child.layoutDirty)
+    return child.boxModel.computedSize;
+
+  const sf::Vector2f previous = child.boxModel.computedSize;
+  child.getBoxModel();
+  child.layoutDirty = false;
+
+  // Padding or size may have changed, so the child re-arranges its own
+  child.invalidateArrangement(previous != child.boxModel.computedSize);
+  if (child.needsLayout())
+    subtreeDirty = true;
+  return child.boxModel.computedSize;
+}
+
+void Container::placeChild(Element &child, const sf::Vector2f &position) {
+  if (child.computedPosition == position)
+    return;
+
+  // Positions are absolute: a moved container must move its children too
+  child.computedPosition = position;
+  child.invalidateArrangement(false);
+  if (child.needsLayout())
+    subtreeDirty = true;
+}
+
+void Container::measureRoot() {
+  // Viewport units anywhere in the tree depend on the window size
+  const sf::Vector2u viewport = getViewportSize();
+  if (viewport != lastViewport) {
+    lastViewport = viewport;
+    layoutDirty = true;
+    invalidateSubtree();
+  }
+
+  // The root has no parent to measure it
+  if (layoutDirty) {
+    const sf::Vector2f previous = boxModel.computedSize;
+    getBoxModel();
+    layoutDirty = false;
+    invalidateArrangement(previous != boxModel.computedSize);
+  }
+}
+
+void Container::layout() {
+  if (!parent)
+    measureRoot();
+
+  if (arrangeDirty) {
+    arrangeDirty = false;
+    if (!children.empty())
+      arrangeChildren();
+  }
+
+  if (subtreeDirty) {
+    subtreeDirty = false;
+    for (auto &ch : children) {
+      if (ch->needsLayout())
+        ch->layout();
+    }
+  }
+}
+
+bool Container::layoutSlice(FrameBudget &budget) {
+  if (!parent)
+    measureRoot();
+
+  if (arrangeDirty) {
+    // Measuring is the bulk of an arrangement and can be spread over
+    // slices: measureChild() skips children measured in an earlier one
+    std::size_t measured = 0;
+    for (auto &ch : children) {
+      if (!ch->layoutDirty)
+        continue;
+      measureChild(*ch);
+      if (++measured % 64 == 0 && budget.expired())
+        return false;
+    }
+    arrangeDirty = false;
+    if (!children.empty())
+      arrangeChildren();
+  }
+  if (!subtreeDirty)
+    return true;
+
+  // Visible children first (the window in this container's layout
+  // coordinates, i.e. without ancestor translates and scrolling); the
+  // budget is checked after each child, so every slice makes progress
+  const sf::Vector2u size = getViewportSize();
+  const sf::Vector2f shift =
+      inheritedDrawState().offset + compositing.translate + getChildOffset();
+  const sf::FloatRect viewport(-shift.x, -shift.y, static_cast<float>(size.x),
+                               static_cast<float>(size.y));
+  std::size_t first = 0, last = 0;
+  childrenIn(viewport, first, last);
+
+  auto visit = [&budget](Element &child) {
+    auto *container = dynamic_cast<Container *>(&child);
+    const bool finished =
+        container ? container->layoutSlice(budget) : (child.layout(), true);
+    return finished && !budget.expired();
+  };
+  for (std::size_t i = first; i < last; ++i) {
+    Element &child = *children[i];
+    if (child.needsLayout() &&
+        viewport.intersects({child.computedPosition,
+                             child.boxModel.computedSize}) &&
+        !visit(child))
+      return false;
+  }
+  for (auto &ch : children) {
+    if (ch->needsLayout() && !visit(*ch))
+      return false;
+  }
+
+  subtreeDirty = false;
+  return true;
+}
+
+void Container::arrangeFlex(const FlexParams &params, WrapMode wrap) {
+  if (wrap == WrapMode::Wrap) {
+    wrapCache.arrange(*this, params);
+    return;
+  }
+
+  const std::size_t count = children.size();
+  layoutSizes.resize(count);
+  layoutPositions.resize(count);
+  for (std::size_t i = 0; i < count; ++i)
+    layoutSizes[i] = measureChild(*children[i]);
+
+  Flex::arrangeLine(layoutSizes.data(), count, params, layoutPositions.data());
+  for (std::size_t i = 0; i < count; ++i)
+    placeChild(*children[i], layoutPositions[i]);
+}
+
+// -------------------------------------------------------------
+// Layout snapshots
+// -------------------------------------------------------------
+
+static bool describesFlex(const Container &container) {
+  LayoutNode node;
+  container.describeLayout(node);
+  return node.flex;
+}
+
+void Container::captureLayout(LayoutSnapshot &snapshot,
+                              std::vector<Element *> &elements,
+                              sf::Vector2u viewport) {
+  snapshot.nodes.clear();
+  snapshot.roots.clear();
+  elements.clear();
+  snapshot.viewport = viewport;
+  snapshot.structureVersion = getStructureVersion();
+
+  // Breadth-first, so the children of a node are contiguous
+  LayoutRoot top;
+  top.position = computedPosition;
+  top.measure = !parent;
+  if (parent)
+    top.content = getContentSize();
+  snapshot.roots.push_back(top);
+  snapshot.nodes.emplace_back();
+  snapshot.nodes[0].style = style;
+  snapshot.nodes[0].box = boxModel;
+  elements.push_back(this);
+
+  for (std::size_t n = 0; n < elements.size(); ++n) {
+    auto *container = dynamic_cast<Container *>(elements[n]);
+    if (!container)
+      continue;
+
+    LayoutNode &node = snapshot.nodes[n];
+    container->describeLayout(node);
+    node.firstChild = snapshot.nodes.size();
+    node.childCount = container->children.size();
+    for (auto &ch : container->children) {
+      LayoutNode child;
+      child.style = ch->style;
+      child.parent = n;
+      snapshot.nodes.push_back(std::move(child));
+      elements.push_back(ch.get());
+    }
+  }
+}
+
+void Container::captureChanges(LayoutSnapshot &snapshot,
+                               std::vector<Ptr> &elements,
+                               std::vector<Ptr> &deferred) {
+  snapshot.nodes.clear();
+  snapshot.roots.clear();
+  elements.clear();
+  snapshot.viewport = getViewportSize();
+  snapshot.structureVersion = getStructureVersion();
+
+  // Measuring the root is a single box; a viewport change invalidates the
+  // whole tree, which is then captured in full
+  measureRoot();
+  captureDirty(Ptr(Ptr(), this), snapshot, elements, deferred);
+}
+
+void Container::captureDirty(const Ptr &self, LayoutSnapshot &snapshot,
+                             std::vector<Ptr> &elements,
+                             std::vector<Ptr> &deferred) {
+  if (!describesFlex(*this)) {
+    if (std::find(deferred.begin(), deferred.end(), self) == deferred.end())
+      deferred.push_back(self);
+    return;
+  }
+  if (arrangeDirty) {
+    captureSubtree(self, snapshot, elements, deferred);
+    return;
+  }
+
+  // Only the dirty paths are walked down to the containers to re-arrange
+  subtreeDirty = false;
+  for (auto &ch : children) {
+    if (!ch->needsLayout())
+      continue;
+    if (auto *container = dynamic_cast<Container *>(ch.get()))
+      container->captureDirty(ch, snapshot, elements, deferred);
+    else
+      ch->layoutDirty = false; // measured by this container's arrangement
+  }
+}
+
+void Container::captureSubtree(const Ptr &self, LayoutSnapshot &snapshot,
+                               std::vector<Ptr> &elements,
+                               std::vector<Ptr> &deferred) {
+  // The top keeps its box and position: its parent is not re-arranged
+  const std::size_t begin = snapshot.nodes.size();
+  LayoutRoot top;
+  top.node = begin;
+  top.position = computedPosition;
+  top.content = getContentSize();
+  snapshot.roots.push_back(top);
+  LayoutNode first;
+  first.style = style;
+  first.parent = begin;
+  first.measured = true;
+  first.box = boxModel;
+  snapshot.nodes.push_back(std::move(first));
+  elements.push_back(self);
+
+  for (std::size_t n = begin; n < elements.size(); ++n) {
+    Element *element = elements[n].get();
+    // Whoever solves the snapshot now owns these invalidations
+    element->layoutDirty = false;
+    auto *container = dynamic_cast<Container *>(element);
+    if (!container) {
+      element->subtreeDirty = false;
+      continue;
+    }
+
+    // Children are captured where they may move or change size: below a
+    // container that must be arranged or is measured again. Anything else
+    // keeps its layout, and is shifted if its container moves
+    const bool remeasured = !snapshot.nodes[n].measured;
+    container->describeLayout(snapshot.nodes[n]);
+    if (!snapshot.nodes[n].flex) {
+      if (container->needsLayout() &&
+          std::find(deferred.begin(), deferred.end(), elements[n]) ==
+              deferred.end())
+        deferred.push_back(elements[n]);
+      continue;
+    }
+    if (n != begin && !remeasured && !container->needsLayout())
+      continue;
+
+    // Same box for the children's % units: clean children keep theirs.
+    // Percentages resolve against the parent's measured box, which is only
+    // current if the parent is not measured again in this snapshot
+    const bool sameBase =
+        !remeasured ||
+        (snapshot.nodes[snapshot.nodes[n].parent].measured &&
+         container->getContentSize() == container->getMeasuredContentSize());
+    container->arrangeDirty = false;
+    container->subtreeDirty = false;
+    container->wrapCache.invalidateFrom(0);
+
+    snapshot.nodes[n].firstChild = snapshot.nodes.size();
+    snapshot.nodes[n].childCount = container->children.size();
+    for (auto &ch : container->children) {
+      LayoutNode child;
+      child.style = ch->style;
+      child.parent = n;
+      child.measured = sameBase && !ch->layoutDirty;
+      if (child.measured)
+        child.box = ch->boxModel;
+      snapshot.nodes.push_back(std::move(child));
+      elements.push_back(ch);
+    }
+  }
+}
+
+void Container::applyLayout(const LayoutResult &result,
+                            const std::vector<Ptr> &elements) {
+  const std::size_t count = std::min(result.nodes.size(), elements.size());
+  for (std::size_t n = 0; n < count; ++n) {
+    const NodeLayout &node = result.nodes[n];
+    if (!node.solved)
+      continue;
+    Element &element = *elements[n];
+    auto *container = dynamic_cast<Container *>(&element);
+
+    if (node.root) {
+      // Moved or resized since the capture (by a layout on this thread):
+      // what was solved below it is stale, so arrange it again
+      if (container && (element.computedPosition != node.position ||
+                        element.boxModel.computedSize !=
+                            node.box.computedSize))
+        container->invalidateChildrenFrom(0);
+      continue;
+    }
+
+    const sf::Vector2f position = element.computedPosition;
+    const sf::Vector2f size = element.boxModel.computedSize;
+    element.boxModel = node.box;
+    element.computedPosition = node.position;
+    if (!container || node.arranged || container->children.empty())
+      continue;
+
+    // Children that were not captured follow their container
+    if (size != node.box.computedSize) {
+      container->invalidateArrangement(true);
+      container->invalidateChildrenFrom(0);
+    } else if (position != node.position) {
+      container->translateChildren(node.position - position);
+    }
+  }
+}
+
+void Container::translateChildren(const sf::Vector2f &delta) {
+  // Positions are absolute, so a moved subtree is shifted, not arranged
+  for (auto &ch : children) {
+    ch->computedPosition += delta;
+    if (auto *container = dynamic_cast<Container *>(ch.get()))
+      container->translateChildren(delta);
+  }
+}
+
+// -------------------------------------------------------------
+// Transactions
+// -------------------------------------------------------------
+
+void Container::beginBatch() { ++getRoot()->batchDepth; }
+
+bool Container::inBatch() const {
+  const Container *root = this;
+  while (root->parent)
+    root = root->parent;
+  return root->batchDepth > 0;
+}
+
+void Container::commitBatch() {
+  Container *root = getRoot();
+  if (root->batchDepth == 0 || --root->batchDepth > 0)
+    return;
+
+  // Apply every recorded invalidation once, then lay out their union
+  std::vector<Element *> pending;
+  pending.swap(root->pendingLayout);
+  for (Element *element : pending) {
+    element->layoutPending = false;
+    element->markLayoutDirty();
+  }
+  root->layout();
+}
+
+void Container::dropPending(Element *element) {
+  if (pendingLayout.empty())
+    return;
+
+  if (element->layoutPending) {
+    element->layoutPending = false;
+    pendingLayout.erase(
+        std::find(pendingLayout.begin(), pendingLayout.end(), element));
+  }
+  if (auto *container = dynamic_cast<Container *>(element)) {
+    for (auto &ch : container->children)
+      dropPending(ch.get());
+  }
+}
+
+// -------------------------------------------------------------
+// Child mutation
+// -------------------------------------------------------------
+
+ElementIndex *Container::findIndex() {
+  Container *root = this;
+  while (root->parent)
+    root = root->parent;
+  return root->index.get();
+}
+
+Stylesheet *Container::getStylesheet() const {
+  const Container *root = this;
+  while (root->parent)
+    root = root->parent;
+  return root->stylesheet;
+}
+
+ElementIndex &Container::getIndex() {
+  Container *root = this;
+  while (root->parent)
+    root = root->parent;
+  if (!root->index) {
+    root->index = std::make_unique<ElementIndex>();
+    root->index->addSubtree(root);
+  }
+  return *root->index;
+}
+
+void Container::adopt(const Ptr &child, ElementIndex *treeIndex) {
+  child->setParent(this);
+  // A detached subtree may have built its own index; the tree's one wins
+  if (auto *container = dynamic_cast<Container *>(child.get()))
+    container->index.reset();
+  if (treeIndex)
+    treeIndex->addSubtree(child.get());
+  if (Stylesheet *sheet = getStylesheet())
+    sheet->restyleSubtree(*child);
+
+  // Re-measure the new child (its % units now resolve against this box)
+  child->layoutDirty = true;
+  child->invalidateArrangement(true);
+  subtreeDirty = true;
+  structureChanged();
+}
+
+void Container::release(const Ptr &child, ElementIndex *treeIndex) {
+  if (treeIndex)
+    treeIndex->removeSubtree(child.get());
+  getRoot()->dropPending(child.get());
+  child->setParent(nullptr);
+  structureChanged();
+}
+
+void Container::renumberFrom(std::size_t first) {
+  for (std::size_t i = first; i < children.size(); ++i)
+    children[i]->indexInParent = i;
+  structureChanged();
+}
+
+void Container::addChild(std::shared_ptr<Element> child) {
+  invalidateChildrenFrom(children.size());
+  child->indexInParent = children.size();
+  children.push_back(child);
+  adopt(child, findIndex());
+}
+
+void Container::insertChildren(std::size_t pos, const std::vector<Ptr> &items) {
+  if (items.empty())
+    return;
+  pos = std::min(pos, children.size());
+
+  children.insert(children.begin() + pos, items.begin(), items.end());
+  renumberFrom(pos);
+  invalidateChildrenFrom(pos);
+
+  ElementIndex *treeIndex = findIndex();
+  for (auto &item : items)
+    adopt(item, treeIndex);
+}
+
+void Container::removeChild(const std::string &id) {
+  const ElementIndex::ElementList &matches = getIndex().findAllById(id);
+  if (matches.size() == 1 && matches.front()->parent == this) {
+    // Common case: the id is unique
+    std::size_t pos = matches.front()->indexInParent;
+    release(children[pos], findIndex());
+    children.erase(children.begin() + pos);
+    renumberFrom(pos);
+    invalidateChildrenFrom(pos);
+    return;
+  }
+  removeChildren({id});
+}
+
+void Container::removeChildren(const std::vector<std::string> &ids) {
+  ElementIndex &treeIndex = getIndex();
+
+  // Mark the children to drop, then compact in a single pass
+  std::vector<char> doomed(children.size(), 0);
+  std::size_t first = children.size();
+  for (const auto &id : ids) {
+    for (Element *element : treeIndex.findAllById(id)) {
+      if (element->parent != this)
+        continue;
+      doomed[element->indexInParent] = 1;
+      first = std::min(first, element->indexInParent);
+    }
+  }
+  if (first == children.size())
+    return;
+
+  std::size_t write = first;
+  for (std::size_t read = first; read < children.size(); ++read) {
+    if (doomed[read])
+      release(children[read], &treeIndex);
+    else
+      children[write++] = std::move(children[read]);
+  }
+  children.resize(write);
+
+  renumberFrom(first);
+  invalidateChildrenFrom(first);
+}
+
+void Container::moveChild(std::size_t from, std::size_t to) {
+  if (from >= children.size() || to >= children.size() || from == to)
+    return;
+
+  auto begin = children.begin();
+  if (from < to)
+    std::rotate(begin + from, begin + from + 1, begin + to + 1);
+  else
+    std::rotate(begin + to, begin + from, begin + from + 1);
+
+  std::size_t first = std::min(from, to);
+  renumberFrom(first);
+  invalidateChildrenFrom(first);
+}
+
+void Container::reorderChildren(const std::vector<std::size_t> &order) {
+  if (order.size() != children.size())
+    return;
+
+  std::size_t first = children.size();
+  std::vector<char> seen(children.size(), 0);
+  std::vector<Ptr> reordered;
+  reordered.reserve(children.size());
+  for (std::size_t i = 0; i < order.size(); ++i) {
+    if (order[i] >= children.size() || seen[order[i]])
+      return; // not a permutation; leave the children untouched
+    seen[order[i]] = 1;
+    if (order[i] != i)
+      first = std::min(first, i);
+    reordered.push_back(children[order[i]]);
+  }
+  if (first == children.size())
+    return;
+
+  children.swap(reordered);
+  renumberFrom(first);
+  invalidateChildrenFrom(first);
+}
+
+void Container::clearChildren() {
+  ElementIndex *treeIndex = findIndex();
+  for (auto &ch : children)
+    release(ch, treeIndex);
+  children.clear();
+  invalidateChildrenFrom(0);
+}
+
+// -------------------------------------------------------------
+// Reconciliation
+// -------------------------------------------------------------
+
+ReconcileStats Container::reconcile(const std::vector<ElementDesc> &desired) {
+  ReconcileStats stats;
+  reconcileChildren(desired, stats);
+  return stats;
+}
+
+// Length of the longest increasing subsequence of `seq`: the kept children
+// that can stay where they are while all others move around them
+static std::size_t longestIncreasingRun(const std::vector<std::size_t> &seq) {
+  std::vector<std::size_t> tails; // smallest tail of each run length
+  for (std::size_t value : seq) {
+    auto it = std::lower_bound(tails.begin(), tails.end(), value);
+    if (it == tails.end())
+      tails.push_back(value);
+    else
+      *it = value;
+  }
+  return tails.size();
+}
+
+void Container::reconcileChildren(const std::vector<ElementDesc> &desired,
+                                  ReconcileStats &stats) {
+  const std::size_t oldCount = children.size();
+  const std::size_t newCount = desired.size();
+
+  // Fast path: same keys and types in the same order, only patch
+  bool sameShape = oldCount == newCount;
+  for (std::size_t i = 0; sameShape && i < newCount; ++i)
+    sameShape = children[i]->id == desired[i].id &&
+                typeid(*children[i]) == *desired[i].type;
+  if (sameShape) {
+    for (std::size_t i = 0; i < newCount; ++i)
+      patch(*children[i], desired[i], stats);
+    return;
+  }
+
+  // ---------- Match every description to an old child ----------
+  static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+  std::vector<std::size_t> source(newCount, npos);
+  std::vector<char> kept(oldCount, 0);
+  ElementIndex *treeIndex = oldCount > 0 ? &getIndex() : nullptr;
+  std::size_t nextUnkeyed = 0;
+
+  for (std::size_t i = 0; i < newCount && oldCount > 0; ++i) {
+    const ElementDesc &desc = desired[i];
+    std::size_t from = npos;
+    if (desc.id->empty()) {
+      while (nextUnkeyed < oldCount && !children[nextUnkeyed]->id->empty())
+        ++nextUnkeyed;
+      if (nextUnkeyed < oldCount)
+        from = nextUnkeyed++;
+    } else if (i < oldCount && !kept[i] && children[i]->id == desc.id) {
+      from = i; // still in place, no lookup needed
+    } else {
+      for (Element *element : treeIndex->findAllById(*desc.id)) {
+        if (element->parent == this && !kept[element->indexInParent]) {
+          from = element->indexInParent;
+          break;
+        }
+      }
+    }
+
+    if (from != npos && typeid(*children[from]) == *desc.type) {
+      source[i] = from;
+      kept[from] = 1;
+    }
+  }
+
+  // ---------- Remove, move and build ----------
+  treeIndex = findIndex();
+  std::vector<std::size_t> keptOrder;
+  for (std::size_t j = 0; j < oldCount; ++j) {
+    if (!kept[j]) {
+      release(children[j], treeIndex);
+      ++stats.removed;
+    }
+  }
+  for (std::size_t from : source)
+    if (from != npos)
+      keptOrder.push_back(from);
+  stats.moved += keptOrder.size() - longestIncreasingRun(keptOrder);
+
+  std::vector<Ptr> next;
+  next.reserve(newCount);
+  std::size_t first = std::min(oldCount, newCount);
+  for (std::size_t i = 0; i < newCount; ++i) {
+    if (source[i] != i)
+      first = std::min(first, i);
+    if (source[i] != npos)
+      next.push_back(std::move(children[source[i]]));
+    else
+      next.push_back(build(desired[i], stats));
+  }
+
+  children.swap(next);
+  renumberFrom(first);
+  invalidateChildrenFrom(first);
+  for (std::size_t i = 0; i < newCount; ++i) {
+    if (source[i] == npos)
+      adopt(children[i], treeIndex);
+    else
+      patch(*children[i], desired[i], stats);
+  }
+}
+
+Container::Ptr Container::build(const ElementDesc &desc,
+                                ReconcileStats &stats) {
+  // The whole subtree is assembled detached, then adopted (and indexed)
+  // in one go by the caller
+  Ptr element = desc.create(window);
+  element->id = desc.id;
+  element->className = desc.className;
+  element->setStyle(desc.style);
+  ++stats.created;
+  if (auto *container = dynamic_cast<Container *>(element.get()))
+    container->reconcileChildren(desc.children, stats);
+  return element;
+}
+
+void Container::patch(Element &element, const ElementDesc &desc,
+                      ReconcileStats &stats) {
+  // Interned values: unchanged ones are the very same pointer. The
+  // description holds the base style (stylesheet rules apply on top)
+  const StyleRef &current =
+      element.sheetStyled ? element.baseStyle : element.style;
+  if (element.className != desc.className || current != desc.style)
+    ++stats.restyled;
+  if (element.className != desc.className)
+    element.setClassName(*desc.className);
+  element.setBaseStyle(desc.style);
+
+  if (auto *container = dynamic_cast<Container *>(&element))
+    container->reconcileChildren(desc.children, stats);
+}
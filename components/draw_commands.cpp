@@ -0,0 +1,275 @@
+#include "../headers/draw_commands.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+
+// -------------------------------------------------------------
+// Recording
+// -------------------------------------------------------------
+
+DrawCommand &DrawCommandList::push(DrawOp op, const sf::FloatRect &rect,
+                                   const sf::Color &color) {
+  commands.emplace_back();
+  DrawCommand &cmd = commands.back();
+  cmd.op = op;
+  cmd.color = color.toInteger();
+  cmd.rect[0] = rect.left;
+  cmd.rect[1] = rect.top;
+  cmd.rect[2] = rect.width;
+  cmd.rect[3] = rect.height;
+  return cmd;
+}
+
+void DrawCommandList::clear(const sf::Color &color) {
+  push(DrawOp::Clear, {}, color);
+}
+
+void DrawCommandList::fillRect(const sf::FloatRect &rect,
+                               const sf::Color &color) {
+  push(DrawOp::FillRect, rect, color);
+}
+
+void DrawCommandList::strokeRect(const sf::FloatRect &rect,
+                                 const sf::Color &color, float thickness) {
+  push(DrawOp::StrokeRect, rect, color).thickness = thickness;
+}
+
+void DrawCommandList::fillRoundedRect(const sf::FloatRect &rect,
+                                      const sf::Color &color,
+                                      const float radii[4]) {
+  DrawCommand &cmd = push(DrawOp::FillRoundedRect, rect, color);
+  std::copy(radii, radii + 4, cmd.radii);
+}
+
+void DrawCommandList::strokeRoundedRect(const sf::FloatRect &rect,
+                                        const sf::Color &color,
+                                        const float radii[4],
+                                        float thickness) {
+  DrawCommand &cmd = push(DrawOp::StrokeRoundedRect, rect, color);
+  std::copy(radii, radii + 4, cmd.radii);
+  cmd.thickness = thickness;
+}
+
+void DrawCommandList::pushClip(const sf::FloatRect &rect) {
+  push(DrawOp::PushClip, rect, sf::Color::Transparent);
+}
+
+void DrawCommandList::popClip() {
+  push(DrawOp::PopClip, {}, sf::Color::Transparent);
+}
+
+void DrawCommandList::beginLayer(int z) {
+  push(DrawOp::Layer, {}, sf::Color::Transparent).layer = z;
+}
+
+// -------------------------------------------------------------
+// Comparison
+// -------------------------------------------------------------
+
+bool DrawCommandList::sameAs(const DrawCommandList &other) const {
+  return commands.size() == other.commands.size() &&
+         (commands.empty() ||
+          std::memcmp(commands.data(), other.commands.data(),
+                      commands.size() * sizeof(DrawCommand)) == 0);
+}
+
+// Pixels a command can touch; false for state-only commands
+static bool commandBounds(const DrawCommand &cmd, sf::Vector2u size,
+                          sf::FloatRect &bounds) {
+  switch (cmd.op) {
+  case DrawOp::Clear:
+    bounds = {0.0f, 0.0f, static_cast<float>(size.x),
+              static_cast<float>(size.y)};
+    return true;
+  case DrawOp::StrokeRect: {
+    // Outline grows outwards
+    const float t = std::max(0.0f, cmd.thickness);
+    bounds = {cmd.rect[0] - t, cmd.rect[1] - t, cmd.rect[2] + 2 * t,
+              cmd.rect[3] + 2 * t};
+    return true;
+  }
+  case DrawOp::FillRect:
+  case DrawOp::FillRoundedRect:
+  case DrawOp::StrokeRoundedRect:
+    bounds = {cmd.rect[0], cmd.rect[1], cmd.rect[2], cmd.rect[3]};
+    return true;
+  default:
+    return false;
+  }
+}
+
+static void unite(sf::FloatRect &total, bool &any, const sf::FloatRect &r) {
+  if (!any) {
+    total = r;
+    any = true;
+    return;
+  }
+  const float left = std::min(total.left, r.left);
+  const float top = std::min(total.top, r.top);
+  const float right = std::max(total.left + total.width, r.left + r.width);
+  const float bottom = std::max(total.top + total.height, r.top + r.height);
+  total = {left, top, right - left, bottom - top};
+}
+
+sf::FloatRect DrawCommandList::damage(const DrawCommandList &previous) const {
+  const std::vector<DrawCommand> &old = previous.commands;
+  const sf::FloatRect everything(0.0f, 0.0f, static_cast<float>(size.x),
+                                 static_cast<float>(size.y));
+  sf::FloatRect total;
+  bool any = false;
+
+  // A changed clip or layer command alters what every later command
+  // covers; repaint everything rather than reason about it
+  const std::size_t common = std::min(commands.size(), old.size());
+  for (std::size_t i = 0; i < common; ++i) {
+    if (std::memcmp(&commands[i], &old[i], sizeof(DrawCommand)) == 0)
+      continue;
+
+    sf::FloatRect now, before;
+    if (!commandBounds(commands[i], size, now) ||
+        !commandBounds(old[i], previous.size, before))
+      return everything;
+    unite(total, any, now);
+    unite(total, any, before);
+  }
+
+  // Commands only one of the frames has
+  const std::vector<DrawCommand> &longer =
+      commands.size() > old.size() ? commands : old;
+  for (std::size_t i = common; i < longer.size(); ++i) {
+    sf::FloatRect bounds;
+    if (!commandBounds(longer[i], size, bounds))
+      return everything;
+    unite(total, any, bounds);
+  }
+
+  if (!any)
+    return {};
+  // Anti-aliased edges reach into the neighbouring pixel
+  total = {std::floor(total.left) - 1.0f, std::floor(total.top) - 1.0f,
+           std::ceil(total.width) + 2.0f, std::ceil(total.height) + 2.0f};
+  sf::FloatRect clipped;
+  return total.intersects(everything, clipped) ? clipped : sf::FloatRect();
+}
+
+// -------------------------------------------------------------
+// Replay and dump
+// -------------------------------------------------------------
+
+static sf::FloatRect rectOf(const DrawCommand &cmd) {
+  return {cmd.rect[0], cmd.rect[1], cmd.rect[2], cmd.rect[3]};
+}
+
+void DrawCommandList::replay(RenderBackend &backend) const {
+  for (const DrawCommand &cmd : commands) {
+    const sf::Color color(cmd.color);
+    switch (cmd.op) {
+    case DrawOp::Clear:
+      backend.clear(color);
+      break;
+    case DrawOp::FillRect:
+      backend.fillRect(rectOf(cmd), color);
+      break;
+    case DrawOp::StrokeRect:
+      backend.strokeRect(rectOf(cmd), color, cmd.thickness);
+      break;
+    case DrawOp::FillRoundedRect:
+      backend.fillRoundedRect(rectOf(cmd), color, cmd.radii);
+      break;
+    case DrawOp::StrokeRoundedRect:
+      backend.strokeRoundedRect(rectOf(cmd), color, cmd.radii, cmd.thickness);
+      break;
+    case DrawOp::PushClip:
+      backend.pushClip(rectOf(cmd));
+      break;
+    case DrawOp::PopClip:
+      backend.popClip();
+      break;
+    case DrawOp::Layer:
+      backend.beginLayer(cmd.layer);
+      break;
+    }
+  }
+}
+
+void DrawCommandList::replay(RenderBackend &backend,
+                             const sf::FloatRect &area) const {
+  backend.pushClip(area);
+  replay(backend);
+  backend.popClip();
+}
+
+void DrawCommandList::dump(std::ostream &out) const {
+  static const char *const names[] = {"clear",
+                                      "fillRect",
+                                      "strokeRect",
+                                      "fillRoundedRect",
+                                      "strokeRoundedRect",
+                                      "pushClip",
+                                      "popClip",
+                                      "layer"};
+
+  const std::ios::fmtflags flags = out.flags();
+  for (const DrawCommand &cmd : commands) {
+    out << names[static_cast<int>(cmd.op)];
+    switch (cmd.op) {
+    case DrawOp::PopClip:
+      break;
+    case DrawOp::Layer:
+      out << ' ' << cmd.layer;
+      break;
+    case DrawOp::Clear:
+      out << " #" << std::hex << std::setw(8) << std::setfill('0')
+          << cmd.color << std::dec;
+      break;
+    default:
+      out << ' ' << cmd.rect[0] << ' ' << cmd.rect[1] << ' ' << cmd.rect[2]
+          << ' ' << cmd.rect[3];
+      if (cmd.op == DrawOp::PushClip)
+        break;
+      out << " #" << std::hex << std::setw(8) << std::setfill('0')
+          << cmd.color << std::dec;
+      if (cmd.op == DrawOp::FillRoundedRect ||
+          cmd.op == DrawOp::StrokeRoundedRect)
+        out << " r=" << cmd.radii[0] << ',' << cmd.radii[1] << ','
+            << cmd.radii[2] << ',' << cmd.radii[3];
+      if (cmd.op == DrawOp::StrokeRect || cmd.op == DrawOp::StrokeRoundedRect)
+        out << " t=" << cmd.thickness;
+      break;
+    }
+    out << '\n';
+  }
+  out.flags(flags);
+}
+
+// -------------------------------------------------------------
+// FrameRecorder
+// -------------------------------------------------------------
+
+FrameRecorder::Result FrameRecorder::present(RenderBackend &target,
+                                             Container &root,
+                                             Renderer &renderer,
+                                             const sf::Color &clearColor,
+                                             bool retained) {
+  const int previous = current;
+  current = 1 - current;
+  DrawCommandList &frame = frames[current];
+  frame.reset();
+  frame.setSize(target.getSize());
+  renderFrame(frame, root, renderer, clearColor);
+
+  const DrawCommandList &last = frames[previous];
+  const bool comparable = hasPrevious && frame.getSize() == last.getSize();
+  hasPrevious = true;
+
+  if (comparable && frame.sameAs(last))
+    return Result::Skipped;
+
+  if (comparable && retained) {
+    frame.replay(target, frame.damage(last));
+    return Result::Partial;
+  }
+  frame.replay(target);
+  return Result::Full;
+}
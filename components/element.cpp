@@ -1,94 +1,328 @@
 #include "../headers/element.hpp"
 #include "../headers/container.hpp"
+#include "../headers/render_backend.hpp"
+#include "../headers/stylesheet.hpp"
+#include <algorithm>
 #include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
 #include <iostream>
-#include <stdexcept> // For std::invalid_argument, std::out_of_range
 
 Element::Element(sf::RenderWindow &wind) : window(wind) {}
 
-// Implementation of the parseUnit method
-float Element::parseUnit(const std::string &unit, Axis axis) const {
-  if (unit.empty()) {
-    return 0.0f;
+// The id/className index of the tree this element is attached to, if built
+static ElementIndex *treeIndexOf(Element *element) {
+  Container *root = element->getParent();
+  if (!root)
+    root = dynamic_cast<Container *>(element);
+  return root ? root->findIndex() : nullptr;
+}
+
+void Element::invalidateLayout() {
+  Container *root =
+      parent ? parent->getRoot() : dynamic_cast<Container *>(this);
+  if (root && root->batchDepth > 0) {
+    // Deferred until the batch commits; recorded once per element
+    if (!layoutPending) {
+      layoutPending = true;
+      root->pendingLayout.push_back(this);
+    }
+    return;
   }
+  markLayoutDirty();
+}
 
-  try {
-    // --- Case 1: Percentage (%) ---
-    if (unit.back() == '%') {
-      float value = std::stof(unit.substr(0, unit.length() - 1));
-      if (!parent) {
-        // No parent, so percentage is meaningless. Default to 0.
-        return 0.0f;
-      }
+void Element::setStyle(const StyleRef &newStyle) {
+  if (newStyle == style)
+    return;
+  style = newStyle;
+  Container *root =
+      parent ? parent->getRoot() : dynamic_cast<Container *>(this);
+  if (root)
+    ++root->styleVersion;
+  invalidateLayout();
+}
 
-      float parentWidth = parseUnit(parent->style.width, Axis::Vertical);
-      float parentHeight = parseUnit(parent->style.height, Axis::Horizontal);
+void Element::markLayoutDirty() {
+  layoutDirty = true;
+  if (parent) {
+    parent->subtreeDirty = true;
+    parent->invalidateChildrenFrom(indexInParent);
+  }
+}
 
-      if (axis == Axis::Horizontal) {
-        return parentWidth * (value / 100.0f);
-      } else {
-        return parentHeight * (value / 100.0f);
-      }
-    }
+// The stylesheet attached to the tree of `element`, if any
+static Stylesheet *treeStylesheetOf(Element *element) {
+  Container *root = element->getParent();
+  if (!root)
+    root = dynamic_cast<Container *>(element);
+  return root ? root->getStylesheet() : nullptr;
+}
 
-    // --- Case 2: Viewport Width (vw) ---
-    else if (unit.length() > 2 && unit.substr(unit.length() - 2) == "vw") {
-      float value = std::stof(unit.substr(0, unit.length() - 2));
-      float windowWidth = static_cast<float>(window.getSize().x);
-      return windowWidth * (value / 100.0f);
-    }
+void Element::setId(const std::string &newId) {
+  ElementIndex *index = treeIndexOf(this);
+  if (index)
+    index->remove(this);
+  id = InternedString(newId);
+  if (index)
+    index->add(this);
+  if (Stylesheet *sheet = treeStylesheetOf(this))
+    sheet->restyle(*this);
+}
 
-    // --- Case 3: Viewport Height (vh) ---
-    else if (unit.length() > 2 && unit.substr(unit.length() - 2) == "vh") {
-      float value = std::stof(unit.substr(0, unit.length() - 2));
-      float windowHeight = static_cast<float>(window.getSize().y);
-      return windowHeight * (value / 100.0f);
-    }
+void Element::setClassName(const std::string &newClassName) {
+  ElementIndex *index = treeIndexOf(this);
+  if (index)
+    index->remove(this);
+  className = InternedString(newClassName);
+  if (index)
+    index->add(this);
+  if (Stylesheet *sheet = treeStylesheetOf(this))
+    sheet->restyle(*this);
+}
 
-    // --- Case 4: Pixels (px or no unit) ---
-    else if (unit.length() > 2 && unit.substr(unit.length() - 2) == "px") {
-      return std::stof(unit.substr(0, unit.length() - 2));
-    } else {
-      // If no unit is specified, assume it's pixels
-      return std::stof(unit);
-    }
+void Element::setBaseStyle(const StyleRef &newStyle) {
+  if (!sheetStyled) {
+    setStyle(newStyle);
+    return;
+  }
+  if (newStyle == baseStyle)
+    return;
+  baseStyle = newStyle;
+  if (Stylesheet *sheet = treeStylesheetOf(this))
+    sheet->restyle(*this);
+  else
+    setStyle(newStyle); // no rules apply outside a styled tree
+}
+
+// -------------------------------------------------------------
+// Input
+// -------------------------------------------------------------
+
+void Element::on(InputEvent::Type type, InputHandler handler) {
+  if (!inputHandlers)
+    inputHandlers = std::make_unique<
+        std::vector<std::pair<InputEvent::Type, InputHandler>>>();
+  inputHandlers->emplace_back(type, std::move(handler));
+}
+
+bool Element::handleInput(InputEvent &event) {
+  if (!inputHandlers)
+    return false;
+  bool handled = false;
+  event.currentTarget = this;
+  for (auto &entry : *inputHandlers) {
+    if (entry.first != event.type)
+      continue;
+    event.ignored = false;
+    entry.second(event);
+    if (!event.ignored)
+      handled = true;
+  }
+  return handled;
+}
+
+// -------------------------------------------------------------
+// Interned styles
+// -------------------------------------------------------------
+
+bool operator==(const Styles &a, const Styles &b) {
+  for (int i = 0; i < 4; i++) {
+    if (a.border[i] != b.border[i] || a.margin[i] != b.margin[i] ||
+        a.padding[i] != b.padding[i])
+      return false;
+  }
+  return a.width == b.width && a.height == b.height &&
+         a.visible == b.visible && a.borderWidth == b.borderWidth &&
+         a.borderColor == b.borderColor &&
+         a.backgroundColor == b.backgroundColor &&
+         a.relZIndex == b.relZIndex && a.absZIndex == b.absZIndex &&
+         a.gridColumn == b.gridColumn && a.gridRow == b.gridRow &&
+         a.gridColumnSpan == b.gridColumnSpan &&
+         a.gridRowSpan == b.gridRowSpan;
+}
+
+std::size_t std::hash<Styles>::operator()(const Styles &s) const {
+  std::size_t h = 0;
+  auto mix = [&h](std::size_t v) {
+    h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+  };
+  std::hash<std::string> str;
+
+  mix(str(s.width));
+  mix(str(s.height));
+  for (int i = 0; i < 4; i++) {
+    mix(str(s.border[i]));
+    mix(str(s.margin[i]));
+    mix(str(s.padding[i]));
+  }
+  mix(s.visible);
+  mix(std::hash<float>{}(s.borderWidth));
+  mix(s.borderColor.toInteger());
+  mix(s.backgroundColor.toInteger());
+  mix(std::hash<int>{}(s.relZIndex));
+  mix(std::hash<int>{}(s.absZIndex));
+  mix(std::hash<int>{}(s.gridColumn));
+  mix(std::hash<int>{}(s.gridRow));
+  mix(std::hash<int>{}(s.gridColumnSpan));
+  mix(std::hash<int>{}(s.gridRowSpan));
+  return h;
+}
+
+// Heap memory of a string beyond its inline (small string) buffer
+static std::size_t stringHeapBytes(const std::string &s) {
+  return s.capacity() > std::string().capacity() ? s.capacity() + 1 : 0;
+}
+
+StyleMemoryReport styleMemoryReport(std::size_t nodes) {
+  auto &styles = StyleRef::Pool::instance();
+  auto &strings = InternedString::Pool::instance();
+
+  StyleMemoryReport report;
+  report.nodes = nodes;
+  report.styleBlocks = styles.size();
+  report.internedStrings = strings.size();
+  report.poolBytes = styles.bytes([](const Styles &s) {
+    std::size_t bytes = stringHeapBytes(s.width) + stringHeapBytes(s.height);
+    for (int i = 0; i < 4; i++)
+      bytes += stringHeapBytes(s.border[i]) + stringHeapBytes(s.margin[i]) +
+               stringHeapBytes(s.padding[i]);
+    return bytes;
+  });
+  report.poolBytes += strings.bytes(stringHeapBytes);
 
-  } catch (const std::invalid_argument &e) {
+  // Old layout: all of Styles plus id and className inline in every node
+  report.bytesPerNodeBefore = sizeof(Styles) + 2 * sizeof(std::string);
+  report.bytesPerNodeAfter = sizeof(StyleRef) + 2 * sizeof(InternedString);
+  if (nodes > 0)
+    report.bytesPerNodeAfter += report.poolBytes / nodes;
+  return report;
+}
+
+std::size_t collectUnusedStyles() {
+  // Cached resolutions would otherwise keep their styles alive
+  Stylesheet::evictAllUnused();
+  return StyleRef::Pool::instance().collect() +
+         InternedString::Pool::instance().collect();
+}
+
+// Implementation of the parseUnit method
+float Element::parseUnit(const std::string &unit, Axis axis) const {
+  // Only percentages need the parent, and they take its measured box:
+  // re-resolving the parent's own lengths would recurse up the whole chain
+  if (!parent || unit.empty() || unit.back() != '%')
+    return resolveUnit(unit, axis, nullptr, getViewportSize());
+
+  const sf::Vector2f parentContent = parent->getMeasuredContentSize();
+  return resolveUnit(unit, axis, &parentContent, getViewportSize());
+}
+
+// Number at the start of `unit`, without the temporary strings and
+// exceptions of std::stof(unit.substr(...)): this runs for every length of
+// every element on each layout pass
+static float parseNumber(const std::string &unit) {
+  const char *begin = unit.c_str();
+  char *end = nullptr;
+  errno = 0;
+  const float value = std::strtof(begin, &end);
+  if (end == begin) {
     // Could not perform conversion (e.g., unit was "abc%")
     std::cerr << "Warning: Invalid number format in unit string '" << unit
               << "'\n";
     return 0.0f;
-  } catch (const std::out_of_range &e) {
+  }
+  if (errno == ERANGE && std::fabs(value) == HUGE_VALF) {
     // Value was too large to fit in a float
     std::cerr << "Warning: Value out of range in unit string '" << unit
               << "'\n";
     return 0.0f;
   }
+  return value;
 }
 
-const BoxModel Element::getBoxModel() {
+static bool endsWith(const std::string &unit, const char suffix[3]) {
+  return unit.length() > 2 && unit.compare(unit.length() - 2, 2, suffix) == 0;
+}
+
+float Element::resolveUnit(const std::string &unit, Axis axis,
+                           const sf::Vector2f *percentBase,
+                           sf::Vector2u viewport) {
+  if (unit.empty()) {
+    return 0.0f;
+  }
+
+  // --- Case 1: Percentage (%) ---
+  if (unit.back() == '%') {
+    float value = parseNumber(unit);
+    if (!percentBase) {
+      // No parent, so percentage is meaningless. Default to 0.
+      return 0.0f;
+    }
+
+    if (axis == Axis::Horizontal) {
+      return percentBase->x * (value / 100.0f);
+    } else {
+      return percentBase->y * (value / 100.0f);
+    }
+  }
+
+  // --- Case 2: Viewport Width (vw) ---
+  else if (endsWith(unit, "vw")) {
+    float value = parseNumber(unit);
+    float windowWidth = static_cast<float>(viewport.x);
+    return windowWidth * (value / 100.0f);
+  }
+
+  // --- Case 3: Viewport Height (vh) ---
+  else if (endsWith(unit, "vh")) {
+    float value = parseNumber(unit);
+    float windowHeight = static_cast<float>(viewport.y);
+    return windowHeight * (value / 100.0f);
+  }
+
+  // --- Case 4: Pixels (px or no unit) ---
+  // If no unit is specified, assume it's pixels
+  return parseNumber(unit);
+}
+
+BoxModel Element::computeBoxModel(const Styles &styles,
+                                  const sf::Vector2f *percentBase,
+                                  sf::Vector2u viewport) {
+  BoxModel box;
   // Calculate all box model values
   for (int i = 0; i < 4; i++) {
-    boxModel.border[i] = parseUnit(
-        style.border[i], (i % 2 == 0) ? Axis::Vertical : Axis::Horizontal);
-    boxModel.margin[i] = parseUnit(
-        style.margin[i], (i % 2 == 0) ? Axis::Vertical : Axis::Horizontal);
-    boxModel.padding[i] = parseUnit(
-        style.padding[i], (i % 2 == 0) ? Axis::Vertical : Axis::Horizontal);
+    const Axis axis = (i % 2 == 0) ? Axis::Vertical : Axis::Horizontal;
+    box.border[i] = resolveUnit(styles.border[i], axis, percentBase, viewport);
+    box.margin[i] = resolveUnit(styles.margin[i], axis, percentBase, viewport);
+    box.padding[i] =
+        resolveUnit(styles.padding[i], axis, percentBase, viewport);
   }
 
   // Content size (width/height without padding/border/margin)
-  float contentWidth = parseUnit(style.width, Axis::Horizontal);
-  float contentHeight = parseUnit(style.height, Axis::Vertical);
+  float contentWidth =
+      resolveUnit(styles.width, Axis::Horizontal, percentBase, viewport);
+  float contentHeight =
+      resolveUnit(styles.height, Axis::Vertical, percentBase, viewport);
+
+  box.contentSize = {contentWidth, contentHeight};
 
   // Full computed size including padding + border
-  boxModel.computedSize.x = contentWidth + boxModel.padding[1] +
-                            boxModel.padding[3] + boxModel.border[1] +
-                            boxModel.border[3];
-  boxModel.computedSize.y = contentHeight + boxModel.padding[0] +
-                            boxModel.padding[2] + boxModel.border[0] +
-                            boxModel.border[2];
+  box.computedSize.x = contentWidth + box.padding[1] + box.padding[3] +
+                       box.border[1] + box.border[3];
+  box.computedSize.y = contentHeight + box.padding[0] + box.padding[2] +
+                       box.border[0] + box.border[2];
+  return box;
+}
 
+const BoxModel Element::getBoxModel() {
+  if (!parent) {
+    boxModel = computeBoxModel(*style, nullptr, getViewportSize());
+  } else {
+    // Parents are measured before their children
+    const sf::Vector2f parentContent = parent->getMeasuredContentSize();
+    boxModel = computeBoxModel(*style, &parentContent, getViewportSize());
+  }
   return boxModel;
 }
 
@@ -102,8 +336,12 @@ sf::Vector2f Element::getContentPosition() const {
 
 sf::Vector2f Element::getContentSize() const {
   // Size of the actual content area
-  return {parseUnit(style.width, Axis::Horizontal),
-          parseUnit(style.height, Axis::Vertical)};
+  return {parseUnit(style->width, Axis::Horizontal),
+          parseUnit(style->height, Axis::Vertical)};
+}
+
+sf::Vector2f Element::getMeasuredContentSize() const {
+  return boxModel.contentSize;
 }
 
 sf::FloatRect Element::getContentRect() const {
@@ -146,24 +384,52 @@ sf::FloatRect Element::getMarginRect() const {
   };
 }
 
+// -------------------------------------------------------------
+// Drawing (compositing applied on top of the computed layout)
+// -------------------------------------------------------------
+
+DrawState Element::drawState;
+RenderBackend *Element::backend = nullptr;
+sf::Vector2u Element::viewportOverride = {0, 0};
+
+DrawState Element::inheritedDrawState() const {
+  DrawState state;
+  for (const Container *p = parent; p; p = p->getParent()) {
+    state.offset += p->compositing.translate + p->getChildOffset();
+    state.opacity *= p->compositing.opacity;
+  }
+  return state;
+}
+
+static sf::Color withOpacity(sf::Color color, float opacity) {
+  color.a = static_cast<sf::Uint8>(color.a * std::min(1.0f, opacity));
+  return color;
+}
+
 void Element::drawBackground(const sf::FloatRect &rect,
                              const sf::Color &color) {
   if (color != sf::Color::Transparent) {
-    sf::RectangleShape bg(sf::Vector2f(rect.width, rect.height));
-    bg.setFillColor(color);
-    bg.setPosition(rect.left, rect.top);
-    window.draw(bg);
+    const sf::FloatRect moved(rect.left + drawState.offset.x,
+                              rect.top + drawState.offset.y, rect.width,
+                              rect.height);
+    const sf::Color faded = withOpacity(color, drawState.opacity);
+    if (backend)
+      backend->fillRect(moved, faded);
+    else
+      WindowBackend(window).fillRect(moved, faded);
   }
 }
 
 void Element::drawBorder(const sf::FloatRect &rect, const sf::Color &color,
                          float thickness) {
   if (thickness > 0 && color != sf::Color::Transparent) {
-    sf::RectangleShape border(sf::Vector2f(rect.width, rect.height));
-    border.setFillColor(sf::Color::Transparent);
-    border.setOutlineColor(color);
-    border.setOutlineThickness(thickness);
-    border.setPosition(rect.left, rect.top);
-    window.draw(border);
+    const sf::FloatRect moved(rect.left + drawState.offset.x,
+                              rect.top + drawState.offset.y, rect.width,
+                              rect.height);
+    const sf::Color faded = withOpacity(color, drawState.opacity);
+    if (backend)
+      backend->strokeRect(moved, faded, thickness);
+    else
+      WindowBackend(window).strokeRect(moved, faded, thickness);
   }
 }
@@ -0,0 +1,74 @@
+#include "../headers/element_index.hpp"
+#include "../headers/container.hpp"
+#include <algorithm>
+
+void ElementIndex::add(Element *element) {
+  if (!element->getId().empty())
+    byId[element->getId()].push_back(element);
+
+  forEachClass(element->getClassName(), [&](const std::string &cls) {
+    byClass[cls].insert(element);
+  });
+}
+
+void ElementIndex::remove(Element *element) {
+  if (!element->getId().empty()) {
+    auto it = byId.find(element->getId());
+    if (it != byId.end()) {
+      // Other elements sharing the id stay indexed
+      ElementList &list = it->second;
+      list.erase(std::remove(list.begin(), list.end(), element), list.end());
+      if (list.empty())
+        byId.erase(it);
+    }
+  }
+
+  forEachClass(element->getClassName(), [&](const std::string &cls) {
+    auto it = byClass.find(cls);
+    if (it == byClass.end())
+      return;
+    it->second.erase(element);
+    if (it->second.empty())
+      byClass.erase(it);
+  });
+}
+
+void ElementIndex::addSubtree(Element *element) {
+  add(element);
+  if (auto *container = dynamic_cast<Container *>(element)) {
+    for (auto &ch : container->getChildren())
+      addSubtree(ch.get());
+  }
+}
+
+void ElementIndex::removeSubtree(Element *element) {
+  remove(element);
+  if (auto *container = dynamic_cast<Container *>(element)) {
+    for (auto &ch : container->getChildren())
+      removeSubtree(ch.get());
+  }
+}
+
+Element *ElementIndex::findById(const std::string &id) const {
+  auto it = byId.find(id);
+  return it == byId.end() ? nullptr : it->second.back();
+}
+
+const ElementIndex::ElementList &
+ElementIndex::findAllById(const std::string &id) const {
+  static const ElementList empty;
+  auto it = byId.find(id);
+  return it == byId.end() ? empty : it->second;
+}
+
+const ElementIndex::ElementSet &
+ElementIndex::findByClass(const std::string &className) const {
+  static const ElementSet empty;
+  auto it = byClass.find(className);
+  return it == byClass.end() ? empty : it->second;
+}
+
+void ElementIndex::clear() {
+  byId.clear();
+  byClass.clear();
+}
@@ -0,0 +1,183 @@
+#include "../headers/flex_kernel.hpp"
+#include <algorithm>
+
+// The public entry points pick one specialization per call from the axis
+// and alignment, so the per-item loops below carry no runtime branches on
+// the layout properties. Justification only shapes the start offset and
+// gap, which are computed once before the loop.
+
+namespace Flex {
+
+template <Axis A> static float mainOf(const sf::Vector2f &v) {
+  return A == Axis::Horizontal ? v.x : v.y;
+}
+
+template <Axis A> static float crossOf(const sf::Vector2f &v) {
+  return A == Axis::Horizontal ? v.y : v.x;
+}
+
+template <Axis A>
+static sf::Vector2f toPoint(const sf::Vector2f &origin, float main,
+                            float cross) {
+  return A == Axis::Horizontal
+             ? sf::Vector2f(origin.x + main, origin.y + cross)
+             : sf::Vector2f(origin.x + cross, origin.y + main);
+}
+
+template <AlignItems Al> static float align(float space, float size) {
+  return Al == AlignItems::Center ? (space - size) / 2.0f
+         : Al == AlignItems::End  ? space - size
+                                  : 0.0f;
+}
+
+// Start offset and per-item gap for `count` items with `extraSpace` free
+static void justify(JustifyContent mode, float extraSpace, std::size_t count,
+                    float gap, float &startOffset, float &itemGap) {
+  const float n = static_cast<float>(count);
+  startOffset = 0.0f;
+  itemGap = gap;
+
+  switch (mode) {
+  case JustifyContent::Center:
+    startOffset = extraSpace / 2.0f;
+    break;
+  case JustifyContent::End:
+    startOffset = extraSpace;
+    break;
+  case JustifyContent::SpaceBetween:
+    if (count > 1)
+      itemGap += extraSpace / (n - 1.0f);
+    break;
+  case JustifyContent::SpaceAround:
+    itemGap += extraSpace / n;
+    startOffset = extraSpace / n / 2.0f;
+    break;
+  case JustifyContent::SpaceEvenly:
+    itemGap += extraSpace / (n + 1.0f);
+    startOffset = extraSpace / (n + 1.0f);
+    break;
+  default:
+    break;
+  }
+}
+
+// ---------- Specialized kernels ----------
+
+template <Axis A>
+static float mainTotal(const sf::Vector2f *sizes, std::size_t count) {
+  float total = 0.0f;
+  for (std::size_t i = 0; i < count; ++i)
+    total += mainOf<A>(sizes[i]);
+  return total;
+}
+
+template <Axis A, AlignItems Al>
+static void placeRun(const sf::Vector2f *sizes, std::size_t begin,
+                     std::size_t end, const sf::Vector2f &origin, float main,
+                     float itemGap, float crossOffset, float crossSpace,
+                     sf::Vector2f *positions) {
+  for (std::size_t i = begin; i < end; ++i) {
+    const float cross =
+        crossOffset + align<Al>(crossSpace, crossOf<A>(sizes[i]));
+    positions[i] = toPoint<A>(origin, main, cross);
+    main += mainOf<A>(sizes[i]) + itemGap;
+  }
+}
+
+template <Axis A>
+static void breakLinesOn(const sf::Vector2f *sizes, std::size_t begin,
+                         std::size_t end, float mainLimit, float gap,
+                         float crossOffset, std::vector<WrapLine> &lines) {
+  std::size_t i = begin;
+  while (i < end) {
+    WrapLine line;
+    line.start = i;
+    line.crossOffset = crossOffset;
+
+    // The first item always fits, so a single oversized item still gets a
+    // line of its own
+    line.mainExtent = mainOf<A>(sizes[i]);
+    line.crossExtent = crossOf<A>(sizes[i]);
+    line.count = 1;
+    for (++i; i < end; ++i) {
+      const float extent = line.mainExtent + gap + mainOf<A>(sizes[i]);
+      if (extent > mainLimit)
+        break;
+      line.mainExtent = extent;
+      line.crossExtent = std::max(line.crossExtent, crossOf<A>(sizes[i]));
+      ++line.count;
+    }
+
+    lines.push_back(line);
+    crossOffset += line.crossExtent + gap;
+  }
+}
+
+// ---------- Dispatch tables: [axis][align] ----------
+
+using RunKernel = void (*)(const sf::Vector2f *, std::size_t, std::size_t,
+                           const sf::Vector2f &, float, float, float, float,
+                           sf::Vector2f *);
+
+static const RunKernel runKernels[2][3] = {
+    {placeRun<Axis::Horizontal, AlignItems::Start>,
+     placeRun<Axis::Horizontal, AlignItems::Center>,
+     placeRun<Axis::Horizontal, AlignItems::End>},
+    {placeRun<Axis::Vertical, AlignItems::Start>,
+     placeRun<Axis::Vertical, AlignItems::Center>,
+     placeRun<Axis::Vertical, AlignItems::End>}};
+
+static RunKernel runKernel(const FlexParams &params) {
+  return runKernels[static_cast<int>(params.mainAxis)]
+                   [static_cast<int>(params.align)];
+}
+
+// ---------- Public entry points ----------
+
+void arrangeLine(const sf::Vector2f *sizes, std::size_t count,
+                 const FlexParams &params, sf::Vector2f *positions) {
+  if (count == 0)
+    return;
+
+  // ---------- Compute total size along the main axis ----------
+  float total = params.mainAxis == Axis::Horizontal
+                    ? mainTotal<Axis::Horizontal>(sizes, count)
+                    : mainTotal<Axis::Vertical>(sizes, count);
+  total += params.gap * (count - 1);
+
+  // ---------- Calculate justification ----------
+  float startOffset, itemGap;
+  justify(params.justify, params.mainLimit - total, count, params.gap,
+          startOffset, itemGap);
+
+  // ---------- Position items ----------
+  runKernel(params)(sizes, 0, count, params.origin,
+                    std::max(0.0f, startOffset), itemGap, 0.0f,
+                    params.crossLimit, positions);
+}
+
+void breakLines(const sf::Vector2f *sizes, std::size_t begin, std::size_t end,
+                const FlexParams &params, float crossOffset,
+                std::vector<WrapLine> &lines) {
+  if (params.mainAxis == Axis::Horizontal)
+    breakLinesOn<Axis::Horizontal>(sizes, begin, end, params.mainLimit,
+                                   params.gap, crossOffset, lines);
+  else
+    breakLinesOn<Axis::Vertical>(sizes, begin, end, params.mainLimit,
+                                 params.gap, crossOffset, lines);
+}
+
+void arrangeWrappedLine(const WrapLine &line, const sf::Vector2f *sizes,
+                        const FlexParams &params, sf::Vector2f *positions) {
+  // ---------- Justify within the line ----------
+  float startOffset, itemGap;
+  justify(params.justify, std::max(0.0f, params.mainLimit - line.mainExtent),
+          line.count, params.gap, startOffset, itemGap);
+
+  // ---------- Position items, aligned within the line ----------
+  runKernel(params)(sizes, line.start, line.start + line.count, params.origin,
+                    startOffset, itemGap, line.crossOffset, line.crossExtent,
+                    positions);
+}
+
+} // namespace Flex
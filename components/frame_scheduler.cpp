@@ -0,0 +1,119 @@
+#include "../headers/frame_scheduler.hpp"
+#include "../headers/container.hpp"
+#include "../headers/layout_pipeline.hpp"
+#include <algorithm>
+
+FrameScheduler::~FrameScheduler() { detach(); }
+
+void FrameScheduler::attach(Container &tree) {
+  Container *top = &tree;
+  while (top->getParent())
+    top = top->getParent();
+  if (root == top)
+    return;
+
+  detach();
+  if (top->scheduler)
+    top->scheduler->detach();
+  root = top;
+  root->scheduler = this;
+}
+
+void FrameScheduler::detach() {
+  if (!root)
+    return;
+  root->scheduler = nullptr;
+  root = nullptr;
+}
+
+// -------------------------------------------------------------
+// Jobs
+// -------------------------------------------------------------
+
+FrameScheduler::JobId FrameScheduler::schedule(Job job, Priority priority) {
+  Entry entry;
+  entry.id = nextId++;
+  entry.job = std::move(job);
+  const JobId id = entry.id;
+  // The lists are being walked: join them once the frame is over
+  if (running)
+    incoming.emplace_back(priority, std::move(entry));
+  else
+    jobs[static_cast<int>(priority)].push_back(std::move(entry));
+  return id;
+}
+
+void FrameScheduler::cancel(JobId id) {
+  // Only marked: the job may be the one running right now
+  for (auto &list : jobs) {
+    for (Entry &entry : list) {
+      if (entry.id == id)
+        entry.done = true;
+    }
+  }
+  for (auto &pending : incoming) {
+    if (pending.second.id == id)
+      pending.second.done = true;
+  }
+}
+
+void FrameScheduler::runJobs(Priority priority, FrameBudget &frame,
+                             bool force) {
+  std::vector<Entry> &list = jobs[static_cast<int>(priority)];
+  for (Entry &entry : list) {
+    if (entry.done)
+      continue;
+    if (frame.expired() && !force)
+      return;
+    force = false;
+    entry.done = entry.job(frame);
+    ++stats.jobSteps;
+  }
+}
+
+// -------------------------------------------------------------
+// Frame
+// -------------------------------------------------------------
+
+bool FrameScheduler::hasWork() const {
+  if (root && (root->pipeline ? root->pipeline->hasWork()
+                              : root->needsLayout()))
+    return true;
+  for (const auto &list : jobs) {
+    if (!list.empty())
+      return true;
+  }
+  return !incoming.empty();
+}
+
+bool FrameScheduler::runFrame() {
+  FrameBudget frame(budget);
+  ++stats.frames;
+  running = true;
+
+  runJobs(Priority::High, frame, true);
+  if (root && root->pipeline)
+    root->pipeline->sync(frame);
+  else if (root && root->needsLayout())
+    root->layoutSlice(frame);
+  runJobs(Priority::Normal, frame, false);
+  runJobs(Priority::Idle, frame, false);
+
+  running = false;
+  for (auto &list : jobs) {
+    list.erase(std::remove_if(list.begin(), list.end(),
+                              [](const Entry &e) { return e.done; }),
+               list.end());
+  }
+  for (auto &pending : incoming) {
+    if (!pending.second.done)
+      jobs[static_cast<int>(pending.first)].push_back(
+          std::move(pending.second));
+  }
+  incoming.clear();
+
+  const bool finished = !hasWork();
+  if (!finished)
+    ++stats.unfinishedFrames;
+  return finished;
+}
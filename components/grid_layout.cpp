@@ -0,0 +1,281 @@
+#include "../headers/grid_layout.hpp"
+#include <algorithm>
+#include <cstdlib>
+
+GridTrack GridTrack::parse(const std::string &spec) {
+  GridTrack track;
+  if (spec.empty() || spec == "auto")
+    return track;
+
+  if (spec.size() > 2 && spec.compare(spec.size() - 2, 2, "fr") == 0) {
+    track.kind = Kind::Fraction;
+    track.fraction = std::max(0.0f, std::strtof(spec.c_str(), nullptr));
+    return track;
+  }
+  track.kind = Kind::Length;
+  track.length = spec;
+  return track;
+}
+
+// -------------------------------------------------------------
+// Track definitions
+// -------------------------------------------------------------
+
+static void parseTracks(const std::vector<std::string> &specs,
+                        std::vector<GridTrack> &tracks) {
+  tracks.clear();
+  tracks.reserve(specs.size());
+  for (const std::string &spec : specs)
+    tracks.push_back(GridTrack::parse(spec));
+}
+
+void GridLayout::setColumns(const std::vector<std::string> &specs) {
+  parseTracks(specs, columns);
+  invalidateChildrenFrom(0);
+}
+
+void GridLayout::setRows(const std::vector<std::string> &specs) {
+  parseTracks(specs, rows);
+  invalidateChildrenFrom(0);
+}
+
+void GridLayout::setAutoRows(const std::string &spec) {
+  autoRows = GridTrack::parse(spec);
+  invalidateChildrenFrom(0);
+}
+
+const GridTrack &GridLayout::trackAt(Axis axis, std::size_t index) const {
+  static const GridTrack implicitColumn;                         // auto
+  static const GridTrack singleColumn = GridTrack::parse("1fr"); // no columns
+  if (axis == Axis::Horizontal) {
+    if (columns.empty())
+      return singleColumn;
+    return index < columns.size() ? columns[index] : implicitColumn;
+  }
+  return index < rows.size() ? rows[index] : autoRows;
+}
+
+// -------------------------------------------------------------
+// Placement
+// -------------------------------------------------------------
+
+bool GridLayout::isFree(std::uint32_t column, std::uint32_t row,
+                        std::uint32_t columnSpan, std::uint32_t rowSpan) {
+  if (column + columnSpan > columnCount)
+    return false;
+  if (row + rowSpan > rowCount) {
+    rowCount = row + rowSpan;
+    occupied.resize(rowCount * columnCount, 0);
+  }
+  for (std::uint32_t r = row; r < row + rowSpan; ++r)
+    for (std::uint32_t c = column; c < column + columnSpan; ++c)
+      if (occupied[r * columnCount + c])
+        return false;
+  return true;
+}
+
+void GridLayout::occupy(const Cell &cell) {
+  if (cell.row + cell.rowSpan > rowCount) {
+    rowCount = cell.row + cell.rowSpan;
+    occupied.resize(rowCount * columnCount, 0);
+  }
+  for (std::uint32_t r = cell.row; r < cell.row + cell.rowSpan; ++r)
+    for (std::uint32_t c = cell.column; c < cell.column + cell.columnSpan; ++c)
+      occupied[r * columnCount + c] = 1;
+}
+
+// Re-stride the occupancy rows in place, from the last one backwards
+void GridLayout::widenColumns(std::size_t count) {
+  occupied.resize(rowCount * count, 0);
+  for (std::size_t r = rowCount; r-- > 0;) {
+    for (std::size_t c = count; c-- > 0;)
+      occupied[r * count + c] = c < columnCount ? occupied[r * columnCount + c]
+                                                : 0;
+  }
+  columnCursor.resize(count, 0);
+  columnCount = count;
+}
+
+void GridLayout::placeCells() {
+  const std::size_t count = children.size();
+  cells.resize(count);
+
+  // Explicit columns, widened by explicit placements and by spans
+  columnCount = std::max<std::size_t>(1, columns.size());
+  std::size_t fixedRows = 0; // rows step 2 places children in
+  for (std::size_t i = 0; i < count; ++i) {
+    const Styles &s = *children[i]->style;
+    Cell &cell = cells[i];
+    cell.columnSpan = static_cast<std::uint32_t>(std::max(1, s.gridColumnSpan));
+    cell.rowSpan = static_cast<std::uint32_t>(std::max(1, s.gridRowSpan));
+    cell.column = s.gridColumn > 0 ? s.gridColumn - 1 : 0;
+    cell.row = s.gridRow > 0 ? s.gridRow - 1 : 0;
+    columnCount = std::max<std::size_t>(columnCount,
+                                        cell.column + cell.columnSpan);
+    if (s.gridRow > 0 && s.gridColumn <= 0)
+      fixedRows = std::max<std::size_t>(fixedRows, cell.row + 1);
+  }
+
+  rowCount = rows.size();
+  occupied.assign(rowCount * columnCount, 0);
+  columnCursor.assign(columnCount, 0);
+  rowCursor.assign(fixedRows, 0);
+
+  // 1. Fully explicit children claim their cells first
+  for (std::size_t i = 0; i < count; ++i) {
+    const Styles &s = *children[i]->style;
+    if (s.gridColumn > 0 && s.gridRow > 0)
+      occupy(cells[i]);
+  }
+
+  // 2. Children with a fixed row take the first free columns in it from
+  // that row's cursor, or implicit columns appended when the row is full
+  for (std::size_t i = 0; i < count; ++i) {
+    const Styles &s = *children[i]->style;
+    if (s.gridRow <= 0 || s.gridColumn > 0)
+      continue;
+    Cell &cell = cells[i];
+    std::uint32_t &cursor = rowCursor[cell.row];
+    cell.column = static_cast<std::uint32_t>(columnCount);
+    for (std::uint32_t c = cursor; c + cell.columnSpan <= columnCount; ++c) {
+      if (isFree(c, cell.row, cell.columnSpan, cell.rowSpan)) {
+        cell.column = c;
+        break;
+      }
+    }
+    cursor = cell.column;
+    if (cell.column + cell.columnSpan > columnCount)
+      widenColumns(cell.column + cell.columnSpan);
+    occupy(cell);
+  }
+
+  // 3. Everything else in child order: a fixed column scans down from
+  // that column's cursor, fully automatic children follow a row-major
+  // cursor that never moves backwards
+  std::uint32_t cursorRow = 0, cursorColumn = 0;
+  for (std::size_t i = 0; i < count; ++i) {
+    const Styles &s = *children[i]->style;
+    if (s.gridRow > 0)
+      continue;
+    Cell &cell = cells[i];
+
+    if (s.gridColumn > 0) {
+      std::uint32_t &cursor = columnCursor[cell.column];
+      while (!isFree(cell.column, cursor, cell.columnSpan, cell.rowSpan))
+        ++cursor;
+      cell.row = cursor;
+    } else {
+      while (!isFree(cursorColumn, cursorRow, cell.columnSpan, cell.rowSpan)) {
+        if (++cursorColumn + cell.columnSpan > columnCount) {
+          cursorColumn = 0;
+          ++cursorRow;
+        }
+      }
+      cell.column = cursorColumn;
+      cell.row = cursorRow;
+      cursorColumn += cell.columnSpan;
+    }
+    occupy(cell);
+  }
+}
+
+// -------------------------------------------------------------
+// Track sizing and arrangement
+// -------------------------------------------------------------
+
+void GridLayout::sizeTracks(Axis axis, const sf::Vector2f &content, float gap,
+                            std::vector<float> &sizes,
+                            std::vector<float> &offsets) {
+  const bool horizontal = axis == Axis::Horizontal;
+  const std::size_t count = horizontal ? columnCount : rowCount;
+  const sf::Vector2u viewport = getViewportSize();
+  sizes.assign(count, 0.0f);
+
+  // Lengths resolve directly; auto tracks take their largest single-span
+  // child (one pass over the cells)
+  float used = count > 0 ? gap * static_cast<float>(count - 1) : 0.0f;
+  float fractions = 0.0f;
+  for (std::size_t t = 0; t < count; ++t) {
+    const GridTrack &track = trackAt(axis, t);
+    if (track.kind == GridTrack::Kind::Length) {
+      sizes[t] = std::max(
+          0.0f, Element::resolveUnit(track.length, axis, &content, viewport));
+      used += sizes[t];
+    } else if (track.kind == GridTrack::Kind::Fraction) {
+      fractions += track.fraction;
+    }
+  }
+  for (std::size_t i = 0; i < cells.size(); ++i) {
+    const Cell &cell = cells[i];
+    const std::uint32_t start = horizontal ? cell.column : cell.row;
+    const std::uint32_t span = horizontal ? cell.columnSpan : cell.rowSpan;
+    if (span != 1 || trackAt(axis, start).kind != GridTrack::Kind::Auto)
+      continue;
+    const float size = horizontal ? layoutSizes[i].x : layoutSizes[i].y;
+    sizes[start] = std::max(sizes[start], size);
+  }
+  for (std::size_t t = 0; t < count; ++t)
+    if (trackAt(axis, t).kind == GridTrack::Kind::Auto)
+      used += sizes[t];
+
+  // Fraction tracks share what is left (like CSS, fractions summing to
+  // less than 1 leave part of it unused)
+  if (fractions > 0.0f) {
+    const float available = horizontal ? content.x : content.y;
+    const float free = std::max(0.0f, available - used);
+    const float unit = free / std::max(1.0f, fractions);
+    for (std::size_t t = 0; t < count; ++t) {
+      const GridTrack &track = trackAt(axis, t);
+      if (track.kind == GridTrack::Kind::Fraction)
+        sizes[t] = unit * track.fraction;
+    }
+  }
+
+  // offsets[t] is where track t starts; offsets[count] is one gap past the
+  // end of the last track
+  offsets.resize(count + 1);
+  offsets[0] = 0.0f;
+  for (std::size_t t = 0; t < count; ++t)
+    offsets[t + 1] = offsets[t] + sizes[t] + gap;
+}
+
+// Offset of an item of `size` in a cell area of `extent`
+static float alignIn(AlignItems align, float extent, float size) {
+  switch (align) {
+  case AlignItems::Center:
+    return (extent - size) / 2.0f;
+  case AlignItems::End:
+    return extent - size;
+  default:
+    return 0.0f;
+  }
+}
+
+void GridLayout::arrangeChildren() {
+  const std::size_t count = children.size();
+  layoutSizes.resize(count);
+  for (std::size_t i = 0; i < count; ++i)
+    layoutSizes[i] = measureChild(*children[i]);
+
+  placeCells();
+
+  const sf::Vector2f content = getContentSize();
+  sizeTracks(Axis::Horizontal, content, columnGap, columnSizes,
+             columnOffsets);
+  sizeTracks(Axis::Vertical, content, rowGap, rowSizes, rowOffsets);
+
+  const sf::Vector2f origin = {computedPosition.x + boxModel.padding[3],
+                               computedPosition.y + boxModel.padding[0]};
+  for (std::size_t i = 0; i < count; ++i) {
+    const Cell &cell = cells[i];
+    const float width = columnOffsets[cell.column + cell.columnSpan] -
+                        columnOffsets[cell.column] - columnGap;
+    const float height =
+        rowOffsets[cell.row + cell.rowSpan] - rowOffsets[cell.row] - rowGap;
+    placeChild(*children[i],
+               {origin.x + columnOffsets[cell.column] +
+                    alignIn(justifyItems, width, layoutSizes[i].x),
+                origin.y + rowOffsets[cell.row] +
+                    alignIn(alignItems, height, layoutSizes[i].y)});
+  }
+}
@@ -0,0 +1,391 @@
+#include "../headers/input.hpp"
+#include <algorithm>
+
+InputDispatcher::InputDispatcher(Container &root) : root(root) {}
+
+// -------------------------------------------------------------
+// Queue
+// -------------------------------------------------------------
+
+void InputDispatcher::push(const sf::Event &event) {
+  ++stats.received;
+
+  // Only runs of the same kind merge; a click between two moves keeps
+  // both moves, so handlers still see where the button went down
+  if (!pending.empty()) {
+    sf::Event &last = pending.back();
+    if (event.type == sf::Event::MouseMoved &&
+        last.type == sf::Event::MouseMoved) {
+      last = event;
+      ++stats.coalesced;
+      return;
+    }
+    if (event.type == sf::Event::MouseWheelScrolled &&
+        last.type == sf::Event::MouseWheelScrolled &&
+        last.mouseWheelScroll.wheel == event.mouseWheelScroll.wheel) {
+      const float delta =
+          last.mouseWheelScroll.delta + event.mouseWheelScroll.delta;
+      last = event;
+      last.mouseWheelScroll.delta = delta;
+      ++stats.coalesced;
+      return;
+    }
+    if (event.type == sf::Event::TouchMoved &&
+        last.type == sf::Event::TouchMoved &&
+        last.touch.finger == event.touch.finger) {
+      last = event;
+      ++stats.coalesced;
+      return;
+    }
+  }
+
+  // Only the final size of a frame matters
+  if (event.type == sf::Event::Resized) {
+    for (sf::Event &queued : pending) {
+      if (queued.type == sf::Event::Resized) {
+        queued = event;
+        ++stats.coalesced;
+        return;
+      }
+    }
+  }
+  pending.push_back(event);
+}
+
+bool InputDispatcher::flush(
+    const std::function<void(const sf::Event &)> &onEvent) {
+  changed = false;
+
+  // Handlers may push more input; that waits for the next flush
+  std::vector<sf::Event> events;
+  events.swap(pending);
+  for (const sf::Event &event : events) {
+    if (onEvent)
+      onEvent(event);
+    route(event);
+  }
+
+  // Hand the buffer back so its capacity is reused
+  events.clear();
+  if (pending.empty())
+    pending.swap(events);
+  return changed;
+}
+
+// -------------------------------------------------------------
+// Routing
+// -------------------------------------------------------------
+
+static sf::Vector2f at(int x, int y) {
+  return {static_cast<float>(x), static_cast<float>(y)};
+}
+
+void InputDispatcher::route(const sf::Event &event) {
+  switch (event.type) {
+  case sf::Event::MouseMoved:
+    pointerEvent(InputEvent::Type::PointerMove,
+                 at(event.mouseMove.x, event.mouseMove.y), 0, sf::Mouse::Left);
+    break;
+  case sf::Event::MouseButtonPressed:
+  case sf::Event::MouseButtonReleased:
+    pointerEvent(event.type == sf::Event::MouseButtonPressed
+                     ? InputEvent::Type::PointerDown
+                     : InputEvent::Type::PointerUp,
+                 at(event.mouseButton.x, event.mouseButton.y), 0,
+                 event.mouseButton.button);
+    break;
+  case sf::Event::TouchBegan:
+  case sf::Event::TouchMoved:
+  case sf::Event::TouchEnded:
+    pointerEvent(event.type == sf::Event::TouchBegan
+                     ? InputEvent::Type::PointerDown
+                 : event.type == sf::Event::TouchMoved
+                     ? InputEvent::Type::PointerMove
+                     : InputEvent::Type::PointerUp,
+                 at(event.touch.x, event.touch.y), event.touch.finger + 1,
+                 sf::Mouse::Left);
+    break;
+  case sf::Event::MouseWheelScrolled: {
+    InputEvent input;
+    input.type = InputEvent::Type::Wheel;
+    input.position = at(event.mouseWheelScroll.x, event.mouseWheelScroll.y);
+    input.wheel = event.mouseWheelScroll.wheel;
+    input.wheelDelta = event.mouseWheelScroll.delta;
+    if (Element *target = hitTest(input.position))
+      dispatch(input, target);
+    break;
+  }
+  case sf::Event::MouseLeft:
+    scratchPath.clear();
+    updateHover(scratchPath);
+    break;
+  case sf::Event::KeyPressed:
+  case sf::Event::KeyReleased:
+  case sf::Event::TextEntered: {
+    InputEvent input;
+    input.type = event.type == sf::Event::KeyPressed    ? InputEvent::Type::KeyDown
+                 : event.type == sf::Event::KeyReleased ? InputEvent::Type::KeyUp
+                                                        : InputEvent::Type::Text;
+    if (event.type == sf::Event::TextEntered)
+      input.unicode = event.text.unicode;
+    else
+      input.key = event.key;
+    input.position = pointer;
+    Element *target = getFocused();
+    dispatch(input, target ? target : &root);
+    break;
+  }
+  default:
+    break;
+  }
+}
+
+void InputDispatcher::pointerEvent(InputEvent::Type type,
+                                   sf::Vector2f position, unsigned pointerId,
+                                   sf::Mouse::Button button) {
+  Element *target = hitTest(position);
+  pathFor(target, scratchPath);
+
+  // Handlers below may remove the target: keep it alive until we are done
+  // (the root has no owner here and outlives the dispatcher)
+  const std::shared_ptr<Element> hold = ownerOf(target);
+
+  // Hover follows the mouse only; a finger does not hover
+  if (pointerId == 0) {
+    pointer = position;
+    updateHover(scratchPath);
+    if (target && !pathFor(target, scratchPath))
+      target = nullptr; // an enter/leave handler took it out of the tree
+  }
+
+  InputEvent input;
+  input.type = type;
+  input.position = position;
+  input.pointer = pointerId;
+  input.button = button;
+  if (target)
+    dispatch(input, target);
+
+  if (type == InputEvent::Type::PointerDown) {
+    // Handlers may have moved the target, or removed it (no path then)
+    pathFor(target, scratchPath);
+    focus = scratchPath.empty() ? PathEntry() : scratchPath.back();
+    setState(active, scratchPath, Element::activeBit, false);
+  } else if (type == InputEvent::Type::PointerUp && !active.empty()) {
+    // Click goes to the deepest element both the press and the release
+    // were over
+    pathFor(target, scratchPath);
+    std::size_t common = 0;
+    while (common < active.size() && common < scratchPath.size() &&
+           active[common].element == scratchPath[common].element &&
+           isAlive(active[common], root))
+      ++common;
+    if (common > 0) {
+      InputEvent click = input;
+      click.type = InputEvent::Type::Click;
+      dispatch(click, active[common - 1].element);
+    }
+    scratchPath.clear();
+    setState(active, scratchPath, Element::activeBit, false);
+  }
+}
+
+bool InputDispatcher::dispatch(InputEvent &event, Element *target) {
+  event.target = target;
+  bool handled = false;
+  std::shared_ptr<Element> hold = ownerOf(target);
+  for (Element *element = target; element;) {
+    // Keep the element and the one the event bubbles to alive while the
+    // handlers run: they may remove either
+    Container *parent = element->getParent();
+    std::shared_ptr<Element> next = parent ? ownerOf(parent) : nullptr;
+
+    if (element->handleInput(event))
+      handled = true;
+    if (!event.bubbles() || event.propagationStopped())
+      break;
+    element = element->getParent();
+    hold = std::move(next);
+  }
+
+  if (handled) {
+    ++stats.dispatched;
+    changed = true;
+  }
+  return handled;
+}
+
+// -------------------------------------------------------------
+// Hover and active state
+// -------------------------------------------------------------
+
+std::shared_ptr<Element> InputDispatcher::ownerOf(Element *element) {
+  Container *parent = element ? element->getParent() : nullptr;
+  if (!parent)
+    return nullptr;
+  return parent->getChildren()[element->getIndexInParent()];
+}
+
+bool InputDispatcher::isAlive(const PathEntry &entry, const Container &root) {
+  return entry.element == &root || !entry.alive.expired();
+}
+
+Element *InputDispatcher::deepest(const Path &path, const Container &root) {
+  for (auto it = path.rbegin(); it != path.rend(); ++it)
+    if (isAlive(*it, root))
+      return it->element;
+  return nullptr;
+}
+
+Element *InputDispatcher::getHovered() const { return deepest(hovered, root); }
+
+Element *InputDispatcher::getFocused() const {
+  return focus.element && isAlive(focus, root) ? focus.element : nullptr;
+}
+
+bool InputDispatcher::pathFor(Element *target, Path &path) {
+  path.clear();
+  for (Element *element = target; element; element = element->getParent()) {
+    PathEntry entry;
+    entry.element = element;
+    entry.alive = ownerOf(element);
+    path.push_back(std::move(entry));
+  }
+
+  // An element removed from the tree has no path
+  if (!path.empty() && path.back().element != &root)
+    path.clear();
+  std::reverse(path.begin(), path.end());
+  return !path.empty();
+}
+
+void InputDispatcher::updateHover(const Path &now) {
+  setState(hovered, now, Element::hoveredBit, true);
+}
+
+void InputDispatcher::setState(Path &path, const Path &now, std::uint8_t bit,
+                               bool sendEvents) {
+  // Both paths start at the root: only the parts after the shared prefix
+  // changed state
+  std::size_t common = 0;
+  while (common < path.size() && common < now.size() &&
+         path[common].element == now[common].element &&
+         isAlive(path[common], root))
+    ++common;
+
+  InputEvent input;
+  input.position = pointer;
+
+  // Leave innermost first, enter outermost first
+  for (std::size_t i = path.size(); i-- > common;) {
+    if (!isAlive(path[i], root))
+      continue;
+    Element *element = path[i].element;
+    element->inputState &= static_cast<std::uint8_t>(~bit);
+    changed = true;
+    if (sendEvents) {
+      input.type = InputEvent::Type::PointerLeave;
+      dispatch(input, element);
+    }
+  }
+  for (std::size_t i = common; i < now.size(); ++i) {
+    // Leave and enter handlers may have removed later entries
+    if (!isAlive(now[i], root))
+      continue;
+    Element *element = now[i].element;
+    element->inputState |= bit;
+    changed = true;
+    if (sendEvents) {
+      input.type = InputEvent::Type::PointerEnter;
+      dispatch(input, element);
+    }
+  }
+  path = now;
+}
+
+// -------------------------------------------------------------
+// Hit testing
+// -------------------------------------------------------------
+
+void InputDispatcher::collectOverlays() {
+  const std::uint64_t structure = root.getStructureVersion();
+  const std::uint64_t styles = root.getStyleVersion();
+  if (overlaysBuilt && overlaysStructure == structure &&
+      overlaysStyle == styles)
+    return;
+  overlaysBuilt = true;
+  overlaysStructure = structure;
+  overlaysStyle = styles;
+
+  // Same set Container::update() submits to the renderer: overlays are
+  // not descended into
+  overlays.clear();
+  std::vector<Element *> stack(1, &root);
+  while (!stack.empty()) {
+    Element *element = stack.back();
+    stack.pop_back();
+    if (element != &root && element->style->absZIndex >= 0) {
+      overlays.push_back(element);
+      continue;
+    }
+    if (auto *container = dynamic_cast<Container *>(element))
+      for (const auto &child : container->getChildren())
+        stack.push_back(child.get());
+  }
+
+  // Highest z first; the stack visits later children first, which are
+  // drawn last among equal z
+  std::stable_sort(overlays.begin(), overlays.end(),
+                   [](const Element *a, const Element *b) {
+                     return a->style->absZIndex > b->style->absZIndex;
+                   });
+}
+
+Element *InputDispatcher::hitTest(sf::Vector2f point) {
+  ++stats.hitTests;
+  collectOverlays();
+  for (Element *overlay : overlays) {
+    if (Element *hit =
+            hitDescend(*overlay, overlay->inheritedDrawState().offset, point))
+      return hit;
+  }
+  return hitDescend(root, {0.0f, 0.0f}, point);
+}
+
+Element *InputDispatcher::hitDescend(Element &element, sf::Vector2f offset,
+                                     sf::Vector2f point) {
+  if (!element.style->visible || element.compositing.opacity <= 0.0f)
+    return nullptr;
+  offset += element.compositing.translate;
+  if (!element.getBorderRect().contains(point - offset))
+    return nullptr;
+
+  auto *container = dynamic_cast<Container *>(&element);
+  if (!container)
+    return &element;
+
+  // Scroll containers: children are only hit where they are shown, moved
+  // by the scroll offset, and only the ones near the point are tested
+  if (container->clipsChildren() &&
+      !container->getPaddingRect().contains(point - offset))
+    return &element;
+  offset += container->getChildOffset();
+  std::size_t first = 0, last = 0;
+  const sf::Vector2f local = point - offset;
+  container->childrenIn({local.x, local.y, 0.0f, 0.0f}, first, last);
+
+  // Topmost child in local stacking: highest relZIndex, later child on ties
+  Element *best = nullptr;
+  int bestZ = 0;
+  const auto &children = container->getChildren();
+  for (std::size_t i = last; i-- > first;) {
+    Element &child = *children[i];
+    if (child.style->absZIndex >= 0 || (best && child.style->relZIndex <= bestZ))
+      continue;
+    if (Element *hit = hitDescend(child, offset, point)) {
+      best = hit;
+      bestZ = child.style->relZIndex;
+    }
+  }
+  return best ? best : &element;
+}
@@ -0,0 +1,181 @@
+#include "../headers/layout_batch.hpp"
+#include <algorithm>
+
+LayoutBatch::LayoutBatch(unsigned threads) {
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  scratch.resize(threads);
+  workers.reserve(threads - 1);
+  for (unsigned i = 1; i < threads; ++i)
+    workers.emplace_back(&LayoutBatch::workerLoop, this, i);
+}
+
+LayoutBatch::~LayoutBatch() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  wake.notify_all();
+  for (std::thread &worker : workers)
+    worker.join();
+}
+
+// -------------------------------------------------------------
+// Batches
+// -------------------------------------------------------------
+
+sf::Vector2u
+LayoutBatch::viewportOf(const std::vector<sf::Vector2u> &viewports,
+                        std::size_t document) {
+  if (viewports.empty())
+    return {0, 0};
+  return viewports.size() == 1 ? viewports[0] : viewports[document];
+}
+
+void LayoutBatch::run(const std::vector<Container *> &roots,
+                      const std::vector<sf::Vector2u> &viewports,
+                      BatchResult &result) {
+  captured.resize(roots.size());
+
+  // Windows are only queried here, never from the workers
+  const std::vector<sf::Vector2u> *sizes = &viewports;
+  if (viewports.empty()) {
+    rootViewports.clear();
+    for (Container *root : roots)
+      rootViewports.push_back(root->getViewportSize());
+    sizes = &rootViewports;
+  }
+
+  parallelFor(roots.size(),
+              [&](std::size_t begin, std::size_t end, Scratch &local) {
+                for (std::size_t d = begin; d < end; ++d)
+                  roots[d]->captureLayout(captured[d], local.elements,
+                                          viewportOf(*sizes, d));
+              });
+
+  solveInto(captured, result);
+}
+
+void LayoutBatch::run(const std::vector<ElementDesc> &documents,
+                      const std::vector<sf::Vector2u> &viewports,
+                      BatchResult &result) {
+  captured.resize(documents.size());
+
+  parallelFor(documents.size(),
+              [&](std::size_t begin, std::size_t end, Scratch &local) {
+                for (std::size_t d = begin; d < end; ++d)
+                  captureLayout(documents[d], captured[d], local.descs,
+                                viewportOf(viewports, d));
+              });
+
+  solveInto(captured, result);
+}
+
+void LayoutBatch::run(const std::vector<LayoutSnapshot> &snapshots,
+                      BatchResult &result) {
+  solveInto(snapshots, result);
+}
+
+void LayoutBatch::solveInto(const std::vector<LayoutSnapshot> &snapshots,
+                            BatchResult &result) {
+  // Every document's slice of the flat buffer is known up front, so the
+  // workers write their results without any further coordination
+  result.offsets.resize(snapshots.size() + 1);
+  result.offsets[0] = 0;
+  for (std::size_t d = 0; d < snapshots.size(); ++d)
+    result.offsets[d + 1] = result.offsets[d] + snapshots[d].nodes.size();
+  result.boxes.resize(result.offsets.back());
+  std::atomic<std::size_t> unsolved{0};
+
+  parallelFor(
+      snapshots.size(),
+      [&](std::size_t begin, std::size_t end, Scratch &local) {
+        for (std::size_t d = begin; d < end; ++d) {
+          const LayoutSnapshot &snapshot = snapshots[d];
+          solveLayout(snapshot, local.result);
+
+          BatchBox *out = result.boxes.data() + result.offsets[d];
+          std::size_t missing = 0;
+          for (std::size_t n = 0; n < snapshot.nodes.size(); ++n) {
+            const NodeLayout &node = local.result.nodes[n];
+            BatchBox &box = out[n];
+            box.x = node.position.x;
+            box.y = node.position.y;
+            box.width = node.box.computedSize.x;
+            box.height = node.box.computedSize.y;
+            box.parent = static_cast<std::uint32_t>(snapshot.nodes[n].parent);
+            box.solved = node.solved ? 1 : 0;
+            missing += node.solved ? 0 : 1;
+          }
+          unsolved.fetch_add(missing, std::memory_order_relaxed);
+        }
+      });
+  result.unsolved = unsolved.load(std::memory_order_relaxed);
+}
+
+// -------------------------------------------------------------
+// Thread pool
+// -------------------------------------------------------------
+
+void LayoutBatch::parallelFor(
+    std::size_t count,
+    std::function<void(std::size_t, std::size_t, Scratch &)> body) {
+  if (count == 0)
+    return;
+
+  // Several chunks per thread: small enough to even out uneven documents,
+  // large enough that the shared counter is not contended
+  const std::size_t threads = getThreadCount();
+  task = std::move(body);
+  jobSize = count;
+  grain = std::max<std::size_t>(1, count / (threads * 8));
+  next.store(0, std::memory_order_relaxed);
+
+  if (workers.empty()) {
+    work(scratch[0]);
+    task = nullptr;
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++generation;
+    busyWorkers = static_cast<unsigned>(workers.size());
+  }
+  wake.notify_all();
+
+  // The calling thread takes chunks too instead of waiting idle
+  work(scratch[0]);
+
+  std::unique_lock<std::mutex> lock(mutex);
+  done.wait(lock, [this] { return busyWorkers == 0; });
+  task = nullptr;
+}
+
+void LayoutBatch::work(Scratch &local) {
+  for (;;) {
+    const std::size_t begin = next.fetch_add(grain, std::memory_order_relaxed);
+    if (begin >= jobSize)
+      return;
+    task(begin, std::min(begin + grain, jobSize), local);
+  }
+}
+
+void LayoutBatch::workerLoop(unsigned index) {
+  std::uint64_t seen = 0;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      wake.wait(lock, [&] { return stopping || generation != seen; });
+      if (stopping)
+        return;
+      seen = generation;
+    }
+
+    work(scratch[index]);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (--busyWorkers == 0)
+      done.notify_one();
+  }
+}
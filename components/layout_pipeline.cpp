@@ -0,0 +1,144 @@
+#include "../headers/layout_pipeline.hpp"
+
+LayoutPipeline::LayoutPipeline(Container &root)
+    : root(root), worker(&LayoutPipeline::run, this) {
+  root.pipeline = this;
+}
+
+LayoutPipeline::~LayoutPipeline() {
+  if (root.pipeline == this)
+    root.pipeline = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(wakeMutex);
+    stopping.store(true, std::memory_order_release);
+  }
+  wake.notify_one();
+  worker.join();
+}
+
+// -------------------------------------------------------------
+// UI thread
+// -------------------------------------------------------------
+
+bool LayoutPipeline::sync() { return sync(nullptr); }
+
+bool LayoutPipeline::sync(FrameBudget &budget) { return sync(&budget); }
+
+bool LayoutPipeline::sync(FrameBudget *budget) {
+  const bool didApply = applyNewest();
+
+  // Viewport units anywhere in the tree depend on the window size
+  const sf::Vector2u viewport = root.getViewportSize();
+  if (viewport != lastViewport) {
+    lastViewport = viewport;
+    root.invalidateLayout();
+  }
+
+  // One capture in flight: its elements must be kept until it is applied.
+  // A half-applied batch is not worth laying out
+  if (appliedSerial == submittedSerial && root.needsLayout() &&
+      !root.inBatch())
+    submit();
+  layoutDeferred(budget);
+  return didApply;
+}
+
+bool LayoutPipeline::hasWork() const {
+  return appliedSerial < submittedSerial || root.needsLayout() ||
+         !deferred.empty();
+}
+
+void LayoutPipeline::flush() {
+  // Applying can invalidate again (e.g. a container resized by the result),
+  // so keep going until nothing is left
+  while (hasWork()) {
+    {
+      std::unique_lock<std::mutex> lock(wakeMutex);
+      solved.wait(lock, [this] {
+        return solvedSerial.load(std::memory_order_acquire) >=
+               submittedSerial;
+      });
+    }
+    sync();
+    if (appliedSerial == submittedSerial && root.inBatch())
+      return; // nothing is submitted until the batch commits
+  }
+}
+
+void LayoutPipeline::submit() {
+  LayoutSnapshot &snapshot = snapshots.back();
+  root.captureChanges(snapshot, elements, deferred);
+  if (snapshot.nodes.empty()) {
+    // Only deferred containers were dirty
+    elements.clear();
+    return;
+  }
+  snapshot.serial = ++submittedSerial;
+  snapshots.publish();
+
+  // Taking the lock orders the notify after a worker that is about to wait
+  { std::lock_guard<std::mutex> lock(wakeMutex); }
+  wake.notify_one();
+}
+
+bool LayoutPipeline::applyNewest() {
+  if (!results.acquire())
+    return false;
+
+  const LayoutResult &result = results.front();
+  if (result.serial <= appliedSerial)
+    return false;
+  appliedSerial = result.serial;
+
+  // The tree may have changed meanwhile; `elements` kept every captured
+  // element alive, and whatever moved is invalidated again
+  root.applyLayout(result, elements);
+  elements.clear();
+  ++applied;
+  return true;
+}
+
+bool LayoutPipeline::layoutDeferred(FrameBudget *budget) {
+  while (!deferred.empty()) {
+    auto *container = static_cast<Container *>(deferred.back().get());
+    // Skipped if removed from the tree since
+    if (container->getRoot() == &root) {
+      if (!budget)
+        container->layout();
+      else if (!container->layoutSlice(*budget))
+        return false;
+    }
+    deferred.pop_back();
+  }
+  return true;
+}
+
+// -------------------------------------------------------------
+// Worker thread
+// -------------------------------------------------------------
+
+void LayoutPipeline::run() {
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(wakeMutex);
+      wake.wait(lock, [this] {
+        return stopping.load(std::memory_order_acquire) ||
+               snapshots.hasFresh();
+      });
+    }
+    if (stopping.load(std::memory_order_acquire))
+      return;
+
+    snapshots.acquire();
+    const LayoutSnapshot &snapshot = snapshots.front();
+    LayoutResult &result = results.back();
+    solveLayout(snapshot, result);
+    results.publish();
+
+    {
+      std::lock_guard<std::mutex> lock(wakeMutex);
+      solvedSerial.store(snapshot.serial, std::memory_order_release);
+    }
+    solved.notify_all();
+  }
+}
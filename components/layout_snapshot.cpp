@@ -0,0 +1,120 @@
+#include "../headers/layout_snapshot.hpp"
+
+void solveLayout(const LayoutSnapshot &snapshot, LayoutResult &result) {
+  const std::size_t count = snapshot.nodes.size();
+  result.nodes.assign(count, NodeLayout{});
+  result.content.resize(count);
+  result.structureVersion = snapshot.structureVersion;
+  result.serial = snapshot.serial;
+  if (count == 0)
+    return;
+
+  // ---------- Roots keep their box, except a tree root's own ----------
+  for (const LayoutRoot &top : snapshot.roots) {
+    const LayoutNode &node = snapshot.nodes[top.node];
+    NodeLayout &root = result.nodes[top.node];
+    if (top.measure) {
+      root.box = Element::computeBoxModel(*node.style, nullptr,
+                                          snapshot.viewport);
+      result.content[top.node] = {
+          Element::resolveUnit(node.style->width, Axis::Horizontal, nullptr,
+                               snapshot.viewport),
+          Element::resolveUnit(node.style->height, Axis::Vertical, nullptr,
+                               snapshot.viewport)};
+    } else {
+      root.box = node.box;
+      result.content[top.node] = top.content;
+    }
+    root.position = top.position;
+    root.solved = true;
+    root.root = true;
+  }
+
+  // Parents come before their children, so one forward pass is enough
+  for (std::size_t n = 0; n < count; ++n) {
+    const LayoutNode &node = snapshot.nodes[n];
+    if (!result.nodes[n].solved || node.childCount == 0 || !node.flex)
+      continue;
+
+    // ---------- Content size (base of the children's % units) ----------
+    sf::Vector2f &content = result.content[n];
+    if (!result.nodes[n].root) {
+      const sf::Vector2f &percentBase = result.content[node.parent];
+      content = {Element::resolveUnit(node.style->width, Axis::Horizontal,
+                                      &percentBase, snapshot.viewport),
+                 Element::resolveUnit(node.style->height, Axis::Vertical,
+                                      &percentBase, snapshot.viewport)};
+    }
+
+    // ---------- Measure children (unless their box is known) ----------
+    result.sizes.resize(node.childCount);
+    result.positions.resize(node.childCount);
+    for (std::size_t i = 0; i < node.childCount; ++i) {
+      const LayoutNode &input = snapshot.nodes[node.firstChild + i];
+      NodeLayout &child = result.nodes[node.firstChild + i];
+      child.box = input.measured
+                      ? input.box
+                      : Element::computeBoxModel(*input.style, &content,
+                                                 snapshot.viewport);
+      child.solved = true;
+      result.sizes[i] = child.box.computedSize;
+    }
+
+    // ---------- Arrange children ----------
+    const NodeLayout &self = result.nodes[n];
+    const bool horizontal = node.flexParams.mainAxis == Axis::Horizontal;
+    FlexParams params = node.flexParams;
+    params.origin = {self.position.x + self.box.padding[3],
+                     self.position.y + self.box.padding[0]};
+    params.mainLimit = horizontal ? content.x : content.y;
+    params.crossLimit = horizontal ? content.y : content.x;
+
+    if (node.wrap == WrapMode::Wrap) {
+      result.lines.clear();
+      Flex::breakLines(result.sizes.data(), 0, node.childCount, params, 0.0f,
+                       result.lines);
+      for (const WrapLine &line : result.lines)
+        Flex::arrangeWrappedLine(line, result.sizes.data(), params,
+                                 result.positions.data());
+    } else {
+      Flex::arrangeLine(result.sizes.data(), node.childCount, params,
+                        result.positions.data());
+    }
+
+    for (std::size_t i = 0; i < node.childCount; ++i)
+      result.nodes[node.firstChild + i].position = result.positions[i];
+    result.nodes[n].arranged = true;
+  }
+}
+
+void captureLayout(const ElementDesc &root, LayoutSnapshot &snapshot,
+                   std::vector<const ElementDesc *> &descs,
+                   sf::Vector2u viewport) {
+  snapshot.nodes.clear();
+  snapshot.roots.clear();
+  descs.clear();
+  snapshot.viewport = viewport;
+  snapshot.structureVersion = 0;
+
+  LayoutRoot top;
+  top.measure = true;
+  snapshot.roots.push_back(top);
+  snapshot.nodes.emplace_back();
+  snapshot.nodes[0].style = root.style;
+  descs.push_back(&root);
+
+  for (std::size_t n = 0; n < descs.size(); ++n) {
+    const ElementDesc &desc = *descs[n];
+    if (desc.describe)
+      desc.describe(snapshot.nodes[n]);
+    snapshot.nodes[n].firstChild = snapshot.nodes.size();
+    snapshot.nodes[n].childCount = desc.children.size();
+    for (const ElementDesc &ch : desc.children) {
+      LayoutNode child;
+      child.style = ch.style;
+      child.parent = n;
+      snapshot.nodes.push_back(std::move(child));
+      descs.push_back(&ch);
+    }
+  }
+}
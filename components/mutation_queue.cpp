@@ -0,0 +1,251 @@
+#include "../headers/mutation_queue.hpp"
+#include "../headers/container.hpp"
+#include <chrono>
+
+MutationQueue::MutationQueue(std::size_t capacity) {
+  std::size_t size = 2;
+  while (size < capacity)
+    size <<= 1;
+  mask = size - 1;
+  slots.reset(new Slot[size]);
+  for (std::size_t i = 0; i < size; ++i)
+    slots[i].sequence.store(i, std::memory_order_relaxed);
+  batch.reserve(size);
+}
+
+MutationQueue::~MutationQueue() = default;
+
+// -------------------------------------------------------------
+// Ring
+// -------------------------------------------------------------
+
+// Each slot's sequence says whose turn it is: == position when free for
+// the producer claiming `position`, == position + 1 once filled, and
+// == position + capacity after the consumer emptied it for the next lap
+
+bool MutationQueue::tryPush(Mutation &mutation) {
+  std::size_t pos = tail.load(std::memory_order_relaxed);
+  for (;;) {
+    Slot &slot = slots[pos & mask];
+    const std::size_t seq = slot.sequence.load(std::memory_order_acquire);
+    const std::intptr_t diff =
+        static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+    if (diff == 0) {
+      if (tail.compare_exchange_weak(pos, pos + 1,
+                                     std::memory_order_relaxed)) {
+        slot.mutation = std::move(mutation);
+        slot.sequence.store(pos + 1, std::memory_order_release);
+        return true;
+      }
+    } else if (diff < 0) {
+      return false; // the consumer has not emptied this slot yet: full
+    } else {
+      pos = tail.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+bool MutationQueue::push(Mutation &&mutation) {
+  if (tryPush(mutation)) {
+    pushed.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+  full.fetch_add(1, std::memory_order_relaxed);
+  // The consumer waiting on itself would never wake up
+  if (!block.load(std::memory_order_relaxed) ||
+      consumer.load(std::memory_order_relaxed) == std::this_thread::get_id())
+    return false;
+
+  // Back off: spin briefly, then sleep until the next drain frees slots
+  for (int attempt = 0; !tryPush(mutation); ++attempt) {
+    if (attempt < 64)
+      std::this_thread::yield();
+    else
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+  }
+  pushed.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+bool MutationQueue::pop(Mutation &out) {
+  Slot &slot = slots[head & mask];
+  if (slot.sequence.load(std::memory_order_acquire) != head + 1)
+    return false;
+  out = std::move(slot.mutation);
+  slot.mutation = Mutation(); // drop references before handing it back
+  slot.sequence.store(head + mask + 1, std::memory_order_release);
+  ++head;
+  return true;
+}
+
+bool MutationQueue::empty() const {
+  return slots[head & mask].sequence.load(std::memory_order_acquire) !=
+         head + 1;
+}
+
+MutationQueue::Stats MutationQueue::getStats() const {
+  Stats stats;
+  stats.pushed = pushed.load(std::memory_order_relaxed);
+  stats.full = full.load(std::memory_order_relaxed);
+  stats.applied = applied;
+  stats.coalesced = coalesced;
+  return stats;
+}
+
+// -------------------------------------------------------------
+// Producers
+// -------------------------------------------------------------
+
+bool MutationQueue::update(const ElementPtr &target, Edit edit) {
+  Mutation m;
+  m.kind = Kind::Edit;
+  m.target = target;
+  m.edit = std::move(edit);
+  return push(std::move(m));
+}
+
+bool MutationQueue::insert(const ElementPtr &container, ElementPtr child,
+                           std::size_t position) {
+  Mutation m;
+  m.kind = Kind::Insert;
+  m.target = container;
+  m.child = std::move(child);
+  m.position = position;
+  return push(std::move(m));
+}
+
+bool MutationQueue::remove(const ElementPtr &container, std::string childId) {
+  Mutation m;
+  m.kind = Kind::Remove;
+  m.target = container;
+  m.id = std::move(childId);
+  return push(std::move(m));
+}
+
+bool MutationQueue::post(Task task) {
+  Mutation m;
+  m.kind = Kind::Task;
+  m.task = std::move(task);
+  return push(std::move(m));
+}
+
+// -------------------------------------------------------------
+// Drain
+// -------------------------------------------------------------
+
+std::size_t MutationQueue::drain() {
+  consumer.store(std::this_thread::get_id(), std::memory_order_relaxed);
+  if (empty())
+    return 0;
+
+  batch.clear();
+  Mutation m;
+  while (batch.size() <= mask && pop(m)) {
+    batch.emplace_back();
+    Entry &entry = batch.back();
+    entry.mutation = std::move(m);
+    if (entry.mutation.kind != Kind::Task)
+      entry.target = entry.mutation.target.lock();
+  }
+
+  // Newest first: a property written again later in the batch is dead,
+  // unless an update() of the element in between may read it
+  seen.clear();
+  barriers.clear();
+  for (std::size_t i = batch.size(); i-- > 0;) {
+    Entry &entry = batch[i];
+    if (entry.mutation.kind != Kind::Edit || !entry.target)
+      continue;
+    Element *element = entry.target.get();
+    if (entry.mutation.property == 0) {
+      ++barriers[element];
+      continue;
+    }
+    auto found = barriers.find(element);
+    const std::size_t barrier = found == barriers.end() ? 0 : found->second;
+    auto written = seen.emplace(
+        std::make_pair(element, entry.mutation.property), barrier);
+    if (!written.second && written.first->second == barrier) {
+      entry.target.reset();
+      ++coalesced;
+    } else {
+      written.first->second = barrier;
+    }
+  }
+
+  const std::uint64_t before = applied;
+  applyEdits();
+  applyInOrder();
+  batch.clear(); // release the elements and closures now, not next frame
+  return static_cast<std::size_t>(applied - before);
+}
+
+void MutationQueue::applyEdits() {
+  // Fold every edit of an element into one copy of its style
+  editing.clear();
+  edited.clear();
+  for (Entry &entry : batch) {
+    if (entry.mutation.kind != Kind::Edit || !entry.target)
+      continue;
+    auto found = editing.emplace(entry.target.get(), edited.size());
+    if (found.second)
+      edited.emplace_back(entry.target, entry.target->getBaseStyle());
+    entry.mutation.edit(edited[found.first->second].second);
+    ++applied;
+  }
+  for (auto &element : edited)
+    element.first->setBaseStyle(StyleRef(element.second));
+  edited.clear();
+}
+
+void MutationQueue::applyInOrder() {
+  for (std::size_t i = 0; i < batch.size();) {
+    Entry &entry = batch[i];
+    const Kind kind = entry.mutation.kind;
+    if (kind == Kind::Task) {
+      entry.mutation.task();
+      ++applied;
+      ++i;
+      continue;
+    }
+    auto *container = dynamic_cast<Container *>(entry.target.get());
+    if (kind == Kind::Edit || !container) {
+      ++i;
+      continue;
+    }
+
+    // Run of appends to / removals from the same container
+    std::size_t end = i + 1;
+    if (kind == Kind::Remove || entry.mutation.position == npos) {
+      while (end < batch.size() && batch[end].mutation.kind == kind &&
+             batch[end].target == entry.target &&
+             (kind == Kind::Remove || batch[end].mutation.position == npos))
+        ++end;
+    }
+
+    if (kind == Kind::Insert) {
+      run.clear();
+      for (std::size_t j = i; j < end; ++j) {
+        if (batch[j].mutation.child && !batch[j].mutation.child->getParent())
+          run.push_back(std::move(batch[j].mutation.child));
+      }
+      const std::size_t position = entry.mutation.position == npos
+                                       ? container->getChildren().size()
+                                       : entry.mutation.position;
+      container->insertChildren(position, run);
+      applied += run.size();
+      run.clear();
+    } else {
+      runIds.clear();
+      for (std::size_t j = i; j < end; ++j)
+        runIds.push_back(std::move(batch[j].mutation.id));
+      if (runIds.size() == 1)
+        container->removeChild(runIds.front());
+      else
+        container->removeChildren(runIds);
+      applied += runIds.size();
+      runIds.clear();
+    }
+    i = end;
+  }
+}
@@ -0,0 +1,113 @@
+#include "../headers/render_backend.hpp"
+#include "../headers/container.hpp"
+#include "../headers/util.hpp"
+
+// -------------------------------------------------------------
+// WindowBackend
+// -------------------------------------------------------------
+
+// Rects are drawn from stack vertex arrays: sf::RectangleShape keeps its
+// vertices in a heap vector, i.e. one allocation per element per frame
+
+void WindowBackend::fillRect(const sf::FloatRect &rect,
+                             const sf::Color &color) {
+  if (clippedOut())
+    return;
+  const float right = rect.left + rect.width;
+  const float bottom = rect.top + rect.height;
+  const sf::Vertex quad[4] = {{{rect.left, rect.top}, color},
+                              {{right, rect.top}, color},
+                              {{rect.left, bottom}, color},
+                              {{right, bottom}, color}};
+  target.draw(quad, 4, sf::TriangleStrip);
+}
+
+void WindowBackend::strokeRect(const sf::FloatRect &rect,
+                               const sf::Color &color, float thickness) {
+  if (thickness == 0.0f || clippedOut())
+    return;
+  // Positive thickness grows outwards, negative inwards (like sf::Shape)
+  const float t = thickness;
+  const float right = rect.left + rect.width;
+  const float bottom = rect.top + rect.height;
+  const sf::Vector2f edge[4] = {
+      {rect.left, rect.top}, {right, rect.top}, {right, bottom},
+      {rect.left, bottom}};
+  const sf::Vector2f grown[4] = {{rect.left - t, rect.top - t},
+                                 {right + t, rect.top - t},
+                                 {right + t, bottom + t},
+                                 {rect.left - t, bottom + t}};
+
+  // Ring strip alternating edge and grown corners, closed on the first pair
+  sf::Vertex strip[10];
+  for (int i = 0; i < 5; ++i) {
+    strip[2 * i] = sf::Vertex(edge[i % 4], color);
+    strip[2 * i + 1] = sf::Vertex(grown[i % 4], color);
+  }
+  target.draw(strip, 10, sf::TriangleStrip);
+}
+
+void WindowBackend::fillRoundedRect(const sf::FloatRect &rect,
+                                    const sf::Color &color,
+                                    const float radii[4]) {
+  if (clippedOut())
+    return;
+  Util::drawRoundedRect(target, rect, color, radii);
+}
+
+void WindowBackend::strokeRoundedRect(const sf::FloatRect &rect,
+                                      const sf::Color &color,
+                                      const float radii[4], float thickness) {
+  if (clippedOut())
+    return;
+  Util::drawRoundedBorder(target, rect, color, radii, thickness);
+}
+
+void WindowBackend::pushClip(const sf::FloatRect &rect) {
+  const sf::Vector2u size = target.getSize();
+  sf::FloatRect clip(0.0f, 0.0f, static_cast<float>(size.x),
+                     static_cast<float>(size.y));
+  if (!clips.empty())
+    clip = clips.back().clip;
+  if (!clip.intersects(rect, clip))
+    clip = sf::FloatRect(rect.left, rect.top, 0.0f, 0.0f);
+  clips.push_back({target.getView(), clip});
+
+  // An empty clip would make a degenerate view; draws are skipped instead
+  if (clippedOut())
+    return;
+
+  // Same world-to-pixel mapping, but only the clip area is rendered
+  sf::View view(clip);
+  if (size.x > 0 && size.y > 0)
+    view.setViewport({clip.left / size.x, clip.top / size.y,
+                      clip.width / size.x, clip.height / size.y});
+  target.setView(view);
+}
+
+void WindowBackend::popClip() {
+  if (clips.empty())
+    return;
+  target.setView(clips.back().view);
+  clips.pop_back();
+}
+
+// -------------------------------------------------------------
+// Frame rendering
+// -------------------------------------------------------------
+
+void renderFrame(RenderBackend &backend, Container &root, Renderer &renderer,
+                 const sf::Color &clearColor) {
+  RenderBackend *previousBackend = Element::backend;
+  const sf::Vector2u previousViewport = Element::viewportOverride;
+  Element::backend = &backend;
+  Element::viewportOverride = backend.getSize();
+
+  backend.clear(clearColor);
+  root.update(renderer);
+  root.draw();
+  renderer.flush();
+
+  Element::backend = previousBackend;
+  Element::viewportOverride = previousViewport;
+}
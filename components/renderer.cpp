@@ -1,5 +1,6 @@
 #include "../headers/renderer.hpp"
 #include "../headers/container.hpp"
+#include "../headers/render_backend.hpp"
 #include <algorithm> // for std::sort
 
 Renderer::Renderer() : root(nullptr) {}
@@ -21,14 +22,26 @@ void Renderer::flush() {
   // Sort elements by their absolute z-index (ascending)
   std::sort(globalDrawList.begin(), globalDrawList.end(),
             [](Element *a, Element *b) {
-              return a->style.absZIndex < b->style.absZIndex;
+              return a->style->absZIndex < b->style->absZIndex;
             });
 
   // Draw each element in sorted order
+  bool firstLayer = true;
+  int layer = 0;
   for (Element *el : globalDrawList) {
-    if (el && el->style.visible)
+    if (el && el->style->visible) {
+      // Recording backends mark where each z-index layer starts
+      if (Element::backend && (firstLayer || el->style->absZIndex != layer)) {
+        firstLayer = false;
+        layer = el->style->absZIndex;
+        Element::backend->beginLayer(layer);
+      }
+      // Overlays still move and fade with their ancestors
+      Element::drawState = el->inheritedDrawState();
       el->draw();
+    }
   }
+  Element::drawState = DrawState();
 
   // Clear the draw list for the next frame
   globalDrawList.clear();
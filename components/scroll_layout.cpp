@@ -0,0 +1,279 @@
+#include "../headers/scroll_layout.hpp"
+#include "../headers/render_backend.hpp"
+#include <algorithm>
+#include <cmath>
+#include <optional>
+
+// Kinetic scrolling stops below this speed (pixels per second)
+static const float stopSpeed = 10.0f;
+// A drag paused for this long before release does not fling
+static const float flingTimeout = 0.1f;
+
+static float along(sf::Vector2f v, Axis axis) {
+  return axis == Axis::Horizontal ? v.x : v.y;
+}
+
+template <Axis MainAxis>
+ScrollLayout<MainAxis>::ScrollLayout(sf::RenderWindow &window)
+    : FlexLayout<MainAxis>(window) {
+  this->on(InputEvent::Type::Wheel, [this](InputEvent &e) { onWheel(e); });
+  for (InputEvent::Type type :
+       {InputEvent::Type::PointerDown, InputEvent::Type::PointerMove,
+        InputEvent::Type::PointerUp})
+    this->on(type, [this](InputEvent &e) { onPointer(e); });
+}
+
+// -------------------------------------------------------------
+// Offset
+// -------------------------------------------------------------
+
+template <Axis MainAxis>
+sf::Vector2f ScrollLayout<MainAxis>::getMaxScroll() const {
+  const sf::FloatRect view = this->getPaddingRect();
+  return {std::max(0.0f, extent.x - view.width),
+          std::max(0.0f, extent.y - view.height)};
+}
+
+template <Axis MainAxis>
+sf::Vector2f ScrollLayout<MainAxis>::clamped(sf::Vector2f offset) const {
+  // Content may have shrunk since the offset was set
+  const sf::Vector2f max = getMaxScroll();
+  return {std::max(0.0f, std::min(offset.x, max.x)),
+          std::max(0.0f, std::min(offset.y, max.y))};
+}
+
+template <Axis MainAxis>
+void ScrollLayout<MainAxis>::scrollTo(sf::Vector2f offset) {
+  scroll = clamped(offset);
+}
+
+template <Axis MainAxis>
+bool ScrollLayout<MainAxis>::canScroll(sf::Vector2f delta) const {
+  return clamped(getScrollOffset() + delta) != getScrollOffset();
+}
+
+template <Axis MainAxis>
+void ScrollLayout<MainAxis>::fling(sf::Vector2f newVelocity) {
+  if (!isScrolling())
+    kineticClock.restart();
+  velocity = newVelocity;
+}
+
+// -------------------------------------------------------------
+// Layout and culling
+// -------------------------------------------------------------
+
+template <Axis MainAxis> void ScrollLayout<MainAxis>::arrangeChildren() {
+  FlexLayout<MainAxis>::arrangeChildren();
+
+  // Scrollable area: the padding box, grown to the far edge (plus end
+  // padding) of every child
+  const sf::FloatRect view = this->getPaddingRect();
+  const BoxModel &own = this->boxModel;
+  sf::Vector2f end = {view.left + view.width, view.top + view.height};
+  for (const auto &ch : this->children) {
+    const BoxModel &box = ch->boxModel;
+    end.x = std::max(end.x, ch->computedPosition.x + box.margin[3] +
+                                box.computedSize.x + box.margin[1] +
+                                own.padding[1]);
+    end.y = std::max(end.y, ch->computedPosition.y + box.margin[0] +
+                                box.computedSize.y + box.margin[2] +
+                                own.padding[2]);
+  }
+  extent = {end.x - view.left, end.y - view.top};
+}
+
+template <Axis MainAxis>
+void ScrollLayout<MainAxis>::childrenIn(const sf::FloatRect &area,
+                                        std::size_t &first,
+                                        std::size_t &last) const {
+  const auto &children = this->children;
+  if (this->wrap == WrapMode::Wrap) {
+    // Lines are not ordered along one axis by start and end alike
+    Container::childrenIn(area, first, last);
+    return;
+  }
+
+  // Unwrapped children are ordered along the main axis
+  const bool horizontal = MainAxis == Axis::Horizontal;
+  const float lo = horizontal ? area.left : area.top;
+  const float hi = lo + (horizontal ? area.width : area.height);
+  auto endOf = [horizontal](const Element &child) {
+    const BoxModel &box = child.boxModel;
+    return along(child.computedPosition, MainAxis) +
+           along(box.computedSize, MainAxis) +
+           (horizontal ? box.margin[3] + box.margin[1]
+                       : box.margin[0] + box.margin[2]);
+  };
+
+  auto begin = std::partition_point(
+      children.begin(), children.end(),
+      [&](const Container::Ptr &ch) { return endOf(*ch) <= lo; });
+  auto end = std::partition_point(begin, children.end(),
+                                  [&](const Container::Ptr &ch) {
+                                    return along(ch->computedPosition,
+                                                 MainAxis) <= hi;
+                                  });
+  first = static_cast<std::size_t>(begin - children.begin());
+  last = static_cast<std::size_t>(end - children.begin());
+}
+
+template <Axis MainAxis>
+sf::FloatRect ScrollLayout<MainAxis>::visibleArea() const {
+  const sf::FloatRect view = this->getPaddingRect();
+  const sf::Vector2f offset = getScrollOffset();
+  return {view.left + offset.x, view.top + offset.y, view.width,
+          view.height};
+}
+
+// -------------------------------------------------------------
+// Frame: kinetic step, then only the children in view
+// -------------------------------------------------------------
+
+template <Axis MainAxis>
+void ScrollLayout<MainAxis>::updateChildren(Renderer &renderer) {
+  if (isScrolling() && !dragging) {
+    // Exact integration of v' = -v / deceleration over the frame
+    const float dt = std::min(kineticClock.restart().asSeconds(), 0.1f);
+    const float decay = std::exp(-dt / deceleration);
+    scrollTo(getScrollOffset() + velocity * (deceleration * (1.0f - decay)));
+    velocity *= decay;
+
+    // Stop at the ends, and once too slow to notice
+    const sf::Vector2f offset = getScrollOffset();
+    const sf::Vector2f max = getMaxScroll();
+    if (std::abs(velocity.x) < stopSpeed ||
+        (velocity.x < 0.0f ? offset.x <= 0.0f : offset.x >= max.x))
+      velocity.x = 0.0f;
+    if (std::abs(velocity.y) < stopSpeed ||
+        (velocity.y < 0.0f ? offset.y <= 0.0f : offset.y >= max.y))
+      velocity.y = 0.0f;
+    if (isScrolling())
+      renderer.requestFrame();
+  }
+
+  std::size_t first = 0, last = 0;
+  childrenIn(visibleArea(), first, last);
+  for (std::size_t i = first; i < last; ++i)
+    this->children[i]->update(renderer);
+}
+
+template <Axis MainAxis> void ScrollLayout<MainAxis>::draw() {
+  if (!this->style->visible || this->compositing.opacity <= 0.0f)
+    return;
+
+  const DrawState saved = this->pushCompositing();
+  this->drawSelf();
+
+  // Children are clipped to the padding box and moved by the offset. They
+  // draw through the backend holding the clip, so without one the window
+  // backend is installed for the duration
+  RenderBackend *previousBackend = Element::backend;
+  std::optional<WindowBackend> windowBackend;
+  if (!previousBackend)
+    Element::backend = &windowBackend.emplace(this->window);
+  RenderBackend &out = *Element::backend;
+  const sf::FloatRect view = this->getPaddingRect();
+  out.pushClip({view.left + Element::drawState.offset.x,
+                view.top + Element::drawState.offset.y, view.width,
+                view.height});
+  Element::drawState.offset += getChildOffset();
+
+  // Same local stacking as Container::draw, over the children in view
+  std::size_t first = 0, last = 0;
+  childrenIn(visibleArea(), first, last);
+  this->sortDrawOrder(first, last);
+  for (Element *ch : this->drawOrder) {
+    if (ch->style->absZIndex < 0)
+      ch->draw();
+  }
+
+  out.popClip();
+  Element::backend = previousBackend;
+  Element::drawState = saved;
+}
+
+// -------------------------------------------------------------
+// Input
+// -------------------------------------------------------------
+
+template <Axis MainAxis>
+void ScrollLayout<MainAxis>::onWheel(InputEvent &event) {
+  // Positive deltas are up/left: towards the start of the content
+  const float distance = -event.wheelDelta * wheelStep;
+  const sf::Vector2f delta = event.wheel == sf::Mouse::VerticalWheel
+                                 ? sf::Vector2f(0.0f, distance)
+                                 : sf::Vector2f(distance, 0.0f);
+  if (!canScroll(delta)) {
+    event.ignore(); // at the end: leave it to an outer scroll container
+    return;
+  }
+
+  // Each notch adds the velocity that coasts `wheelStep` before stopping
+  fling(velocity + delta / deceleration);
+  event.stopPropagation();
+}
+
+template <Axis MainAxis>
+void ScrollLayout<MainAxis>::onPointer(InputEvent &event) {
+  switch (event.type) {
+  case InputEvent::Type::PointerDown:
+    if (event.pointer == 0 && !dragWithMouse) {
+      event.ignore();
+      return;
+    }
+    // Touching the content stops a fling
+    dragging = true;
+    dragLast = event.position;
+    dragClock.restart();
+    stopScrolling();
+    return;
+
+  case InputEvent::Type::PointerMove: {
+    // Hovering, or dragging against an end, moves nothing
+    if (!dragging) {
+      event.ignore();
+      return;
+    }
+    if (!this->isActive()) {
+      // Released outside: the PointerUp went elsewhere
+      dragging = false;
+      event.ignore();
+      return;
+    }
+    const sf::Vector2f delta = dragLast - event.position;
+    const float dt = dragClock.restart().asSeconds();
+    dragLast = event.position;
+    if (!canScroll(delta)) {
+      event.ignore();
+      return;
+    }
+    scrollBy(delta);
+    // Smoothed release velocity
+    if (dt > 0.0f)
+      velocity = velocity * 0.2f + delta * (0.8f / dt);
+    event.stopPropagation();
+    return;
+  }
+
+  case InputEvent::Type::PointerUp: {
+    if (!dragging) {
+      event.ignore();
+      return;
+    }
+    dragging = false;
+    const sf::Vector2f release = velocity;
+    stopScrolling();
+    if (dragClock.getElapsedTime().asSeconds() < flingTimeout)
+      fling(release);
+    return;
+  }
+
+  default:
+    event.ignore();
+    return;
+  }
+}
+
+template class ScrollLayout<Axis::Vertical>;
+template class ScrollLayout<Axis::Horizontal>;
@@ -0,0 +1,419 @@
+#include "../headers/software_rasterizer.hpp"
+#include "../headers/util.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <fstream>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// -------------------------------------------------------------
+// Pixel helpers
+// -------------------------------------------------------------
+
+static std::uint32_t pack(const sf::Color &c) {
+  return static_cast<std::uint32_t>(c.r) |
+         static_cast<std::uint32_t>(c.g) << 8 |
+         static_cast<std::uint32_t>(c.b) << 16 |
+         static_cast<std::uint32_t>(c.a) << 24;
+}
+
+static unsigned channelOf(std::uint32_t pixel, int channel) {
+  return (pixel >> (channel * 8)) & 0xFF;
+}
+
+// Exact x / 255 for x in [0, 255 * 255]
+static unsigned div255(unsigned x) { return (x + 1 + (x >> 8)) >> 8; }
+
+// Source-over with straight alpha: out = src * a + dst * (1 - a)
+static std::uint32_t blend(std::uint32_t dst, const sf::Color &src,
+                           unsigned alpha) {
+  const unsigned inv = 255 - alpha;
+  const unsigned r = div255(src.r * alpha + channelOf(dst, 0) * inv);
+  const unsigned g = div255(src.g * alpha + channelOf(dst, 1) * inv);
+  const unsigned b = div255(src.b * alpha + channelOf(dst, 2) * inv);
+  const unsigned a = div255(255 * alpha + channelOf(dst, 3) * inv);
+  return r | g << 8 | b << 16 | a << 24;
+}
+
+// Overwrite `count` pixels with `value`
+static void storeSpan(std::uint32_t *dst, std::size_t count,
+                      std::uint32_t value) {
+  std::size_t i = 0;
+#if defined(__SSE2__)
+  const __m128i v = _mm_set1_epi32(static_cast<int>(value));
+  for (; i + 4 <= count; i += 4)
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), v);
+#endif
+  for (; i < count; ++i)
+    dst[i] = value;
+}
+
+// Blend `count` pixels with one colour at `alpha` (1..254)
+static void blendSpan(std::uint32_t *dst, std::size_t count,
+                      const sf::Color &color, unsigned alpha) {
+  std::size_t i = 0;
+#if defined(__SSE2__)
+  // Lanes hold 16-bit channels of two pixels: r g b a r g b a
+  const short sr = static_cast<short>(color.r * alpha);
+  const short sg = static_cast<short>(color.g * alpha);
+  const short sb = static_cast<short>(color.b * alpha);
+  const short sa = static_cast<short>(255 * alpha);
+  const __m128i src = _mm_set_epi16(sa, sb, sg, sr, sa, sb, sg, sr);
+  const __m128i inv = _mm_set1_epi16(static_cast<short>(255 - alpha));
+  const __m128i one = _mm_set1_epi16(1);
+  const __m128i zero = _mm_setzero_si128();
+
+  for (; i + 4 <= count; i += 4) {
+    __m128i *p = reinterpret_cast<__m128i *>(dst + i);
+    const __m128i d = _mm_loadu_si128(p);
+    __m128i lo = _mm_unpacklo_epi8(d, zero);
+    __m128i hi = _mm_unpackhi_epi8(d, zero);
+    lo = _mm_add_epi16(_mm_mullo_epi16(lo, inv), src);
+    hi = _mm_add_epi16(_mm_mullo_epi16(hi, inv), src);
+    // div255, same as the scalar path
+    lo = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(lo, one),
+                                      _mm_srli_epi16(lo, 8)),
+                        8);
+    hi = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(hi, one),
+                                      _mm_srli_epi16(hi, 8)),
+                        8);
+    _mm_storeu_si128(p, _mm_packus_epi16(lo, hi));
+  }
+#endif
+  for (; i < count; ++i)
+    dst[i] = blend(dst[i], color, alpha);
+}
+
+// Horizontal extent of a rounded rect at height `cy`; false outside it
+static bool roundedSpan(const sf::FloatRect &rect, const float radii[4],
+                        float cy, float &left, float &right) {
+  const float top = rect.top, bottom = rect.top + rect.height;
+  if (cy < top || cy >= bottom)
+    return false;
+
+  auto inset = [](float radius, float dy) {
+    return radius - std::sqrt(std::max(0.0f, radius * radius - dy * dy));
+  };
+
+  left = rect.left;
+  right = rect.left + rect.width;
+  if (cy < top + radii[0])
+    left += inset(radii[0], top + radii[0] - cy);
+  else if (cy > bottom - radii[3])
+    left += inset(radii[3], cy - (bottom - radii[3]));
+  if (cy < top + radii[1])
+    right -= inset(radii[1], top + radii[1] - cy);
+  else if (cy > bottom - radii[2])
+    right -= inset(radii[2], cy - (bottom - radii[2]));
+  return left < right;
+}
+
+// -------------------------------------------------------------
+// SoftwareRasterizer
+// -------------------------------------------------------------
+
+SoftwareRasterizer::SoftwareRasterizer(unsigned width, unsigned height) {
+  resize(width, height);
+}
+
+void SoftwareRasterizer::resize(unsigned newWidth, unsigned newHeight) {
+  width = newWidth;
+  height = newHeight;
+  pixels.assign(static_cast<std::size_t>(width) * height, 0);
+  clip = {0, 0, static_cast<int>(width), static_cast<int>(height)};
+  clips.clear();
+}
+
+void SoftwareRasterizer::clear(const sf::Color &color) {
+  if (clip.x0 == 0 && clip.y0 == 0 && clip.x1 == static_cast<int>(width) &&
+      clip.y1 == static_cast<int>(height)) {
+    storeSpan(pixels.data(), pixels.size(), pack(color));
+    return;
+  }
+  for (int y = clip.y0; y < clip.y1; ++y)
+    storeSpan(pixels.data() + static_cast<std::size_t>(y) * width + clip.x0,
+              std::max(0, clip.x1 - clip.x0), pack(color));
+}
+
+void SoftwareRasterizer::pushClip(const sf::FloatRect &rect) {
+  clips.push_back(clip);
+  // Same pixel-centre rule as fillRect
+  clip.x0 = std::max(clip.x0, static_cast<int>(std::ceil(rect.left - 0.5f)));
+  clip.y0 = std::max(clip.y0, static_cast<int>(std::ceil(rect.top - 0.5f)));
+  clip.x1 = std::min(clip.x1, static_cast<int>(std::ceil(
+                                  rect.left + rect.width - 0.5f)));
+  clip.y1 = std::min(clip.y1, static_cast<int>(std::ceil(
+                                  rect.top + rect.height - 0.5f)));
+}
+
+void SoftwareRasterizer::popClip() {
+  if (clips.empty())
+    return;
+  clip = clips.back();
+  clips.pop_back();
+}
+
+void SoftwareRasterizer::fillSpan(int y, int x0, int x1,
+                                  const sf::Color &color) {
+  if (x1 <= x0 || color.a == 0)
+    return;
+  std::uint32_t *row = pixels.data() + static_cast<std::size_t>(y) * width;
+  if (color.a == 255)
+    storeSpan(row + x0, x1 - x0, pack(color));
+  else
+    blendSpan(row + x0, x1 - x0, color, color.a);
+}
+
+void SoftwareRasterizer::blendPixel(std::uint32_t &pixel,
+                                    const sf::Color &color, unsigned alpha) {
+  if (alpha >= 255)
+    pixel = pack(color);
+  else if (alpha > 0)
+    pixel = blend(pixel, color, alpha);
+}
+
+void SoftwareRasterizer::fillCoverage(int y, float left, float right,
+                                      const sf::Color &color) {
+  left = std::max(left, static_cast<float>(clip.x0));
+  right = std::min(right, static_cast<float>(clip.x1));
+  if (right <= left)
+    return;
+
+  std::uint32_t *row = pixels.data() + static_cast<std::size_t>(y) * width;
+  const int first = static_cast<int>(std::floor(left));
+  const int last = static_cast<int>(std::ceil(right)) - 1;
+  auto partial = [&](int x, float coverage) {
+    blendPixel(row[x], color,
+               static_cast<unsigned>(color.a * coverage + 0.5f));
+  };
+
+  if (first == last) {
+    partial(first, right - left);
+    return;
+  }
+  partial(first, static_cast<float>(first + 1) - left);
+  fillSpan(y, first + 1, last, color);
+  partial(last, right - static_cast<float>(last));
+}
+
+void SoftwareRasterizer::fillRect(const sf::FloatRect &rect,
+                                  const sf::Color &color) {
+  // Pixels whose centres lie inside the rect, like the GPU rasterizer
+  const int x0 =
+      std::max(clip.x0, static_cast<int>(std::ceil(rect.left - 0.5f)));
+  const int y0 =
+      std::max(clip.y0, static_cast<int>(std::ceil(rect.top - 0.5f)));
+  const int x1 = std::min(
+      clip.x1, static_cast<int>(std::ceil(rect.left + rect.width - 0.5f)));
+  const int y1 = std::min(
+      clip.y1, static_cast<int>(std::ceil(rect.top + rect.height - 0.5f)));
+  for (int y = y0; y < y1; ++y)
+    fillSpan(y, x0, x1, color);
+}
+
+void SoftwareRasterizer::strokeRect(const sf::FloatRect &rect,
+                                    const sf::Color &color, float thickness) {
+  if (thickness == 0.0f)
+    return;
+
+  // Positive thickness grows outwards, negative inwards (as in SFML)
+  const float t = std::abs(thickness);
+  sf::FloatRect outer = rect, inner = rect;
+  if (thickness > 0.0f)
+    outer = {rect.left - t, rect.top - t, rect.width + 2 * t,
+             rect.height + 2 * t};
+  else
+    inner = {rect.left + t, rect.top + t, std::max(0.0f, rect.width - 2 * t),
+             std::max(0.0f, rect.height - 2 * t)};
+
+  const float innerBottom = inner.top + inner.height;
+  const float outerBottom = outer.top + outer.height;
+  fillRect({outer.left, outer.top, outer.width, inner.top - outer.top}, color);
+  fillRect({outer.left, innerBottom, outer.width, outerBottom - innerBottom},
+           color);
+  fillRect({outer.left, inner.top, inner.left - outer.left, inner.height},
+           color);
+  fillRect({inner.left + inner.width, inner.top,
+            outer.left + outer.width - inner.left - inner.width, inner.height},
+           color);
+}
+
+void SoftwareRasterizer::fillRoundedRect(const sf::FloatRect &rect,
+                                         const sf::Color &color,
+                                         const float radii[4]) {
+  float fitted[4];
+  Util::fitRadii(rect, radii, fitted);
+
+  const int y0 = std::max(clip.y0, static_cast<int>(std::floor(rect.top)));
+  const int y1 = std::min(clip.y1,
+                          static_cast<int>(std::ceil(rect.top + rect.height)));
+  for (int y = y0; y < y1; ++y) {
+    float left, right;
+    if (roundedSpan(rect, fitted, y + 0.5f, left, right))
+      fillCoverage(y, left, right, color);
+  }
+}
+
+void SoftwareRasterizer::strokeRoundedRect(const sf::FloatRect &rect,
+                                           const sf::Color &color,
+                                           const float radii[4],
+                                           float thickness) {
+  if (thickness <= 0.0f)
+    return;
+
+  float outerRadii[4], innerRadii[4], shrunk[4];
+  Util::fitRadii(rect, radii, outerRadii);
+  const sf::FloatRect inner = {rect.left + thickness, rect.top + thickness,
+                               rect.width - 2 * thickness,
+                               rect.height - 2 * thickness};
+  for (int i = 0; i < 4; ++i)
+    shrunk[i] = std::max(0.0f, outerRadii[i] - thickness);
+  Util::fitRadii(inner, shrunk, innerRadii);
+  const bool hasInner = inner.width > 0.0f && inner.height > 0.0f;
+
+  const int y0 = std::max(clip.y0, static_cast<int>(std::floor(rect.top)));
+  const int y1 = std::min(clip.y1,
+                          static_cast<int>(std::ceil(rect.top + rect.height)));
+  for (int y = y0; y < y1; ++y) {
+    const float cy = y + 0.5f;
+    float left, right, innerLeft, innerRight;
+    if (!roundedSpan(rect, outerRadii, cy, left, right))
+      continue;
+
+    // Ring: the outer span minus the inner one
+    if (hasInner &&
+        roundedSpan(inner, innerRadii, cy, innerLeft, innerRight)) {
+      fillCoverage(y, left, innerLeft, color);
+      fillCoverage(y, innerRight, right, color);
+    } else {
+      fillCoverage(y, left, right, color);
+    }
+  }
+}
+
+sf::Color SoftwareRasterizer::getPixel(unsigned x, unsigned y) const {
+  if (x >= width || y >= height)
+    return sf::Color::Transparent;
+  const std::uint32_t p = pixels[static_cast<std::size_t>(y) * width + x];
+  return sf::Color(channelOf(p, 0), channelOf(p, 1), channelOf(p, 2),
+                   channelOf(p, 3));
+}
+
+// -------------------------------------------------------------
+// Image output
+// -------------------------------------------------------------
+
+bool SoftwareRasterizer::savePpm(const std::string &path) const {
+  std::ofstream out(path, std::ios::binary);
+  if (!out)
+    return false;
+
+  out << "P6\n" << width << ' ' << height << "\n255\n";
+  std::vector<char> row(static_cast<std::size_t>(width) * 3);
+  for (unsigned y = 0; y < height; ++y) {
+    const std::uint32_t *src =
+        pixels.data() + static_cast<std::size_t>(y) * width;
+    for (unsigned x = 0; x < width; ++x) {
+      for (int c = 0; c < 3; ++c)
+        row[x * 3 + c] = static_cast<char>(channelOf(src[x], c));
+    }
+    out.write(row.data(), static_cast<std::streamsize>(row.size()));
+  }
+  return static_cast<bool>(out);
+}
+
+static std::array<std::uint32_t, 256> makeCrcTable() {
+  std::array<std::uint32_t, 256> table;
+  for (std::uint32_t n = 0; n < 256; ++n) {
+    std::uint32_t c = n;
+    for (int k = 0; k < 8; ++k)
+      c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+    table[n] = c;
+  }
+  return table;
+}
+
+static std::uint32_t crc32(const std::uint8_t *data, std::size_t size,
+                           std::uint32_t crc = 0) {
+  static const std::array<std::uint32_t, 256> table = makeCrcTable();
+  crc = ~crc;
+  for (std::size_t i = 0; i < size; ++i)
+    crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  return ~crc;
+}
+
+static void putBE32(std::vector<std::uint8_t> &out, std::uint32_t v) {
+  out.push_back(static_cast<std::uint8_t>(v >> 24));
+  out.push_back(static_cast<std::uint8_t>(v >> 16));
+  out.push_back(static_cast<std::uint8_t>(v >> 8));
+  out.push_back(static_cast<std::uint8_t>(v));
+}
+
+static void putChunk(std::vector<std::uint8_t> &out, const char type[4],
+                     const std::vector<std::uint8_t> &data) {
+  putBE32(out, static_cast<std::uint32_t>(data.size()));
+  const std::size_t start = out.size();
+  out.insert(out.end(), type, type + 4);
+  out.insert(out.end(), data.begin(), data.end());
+  putBE32(out, crc32(out.data() + start, out.size() - start));
+}
+
+bool SoftwareRasterizer::savePng(const std::string &path) const {
+  // ---------- Raw scanlines: filter byte 0, then RGBA ----------
+  const std::size_t stride = static_cast<std::size_t>(width) * 4 + 1;
+  std::vector<std::uint8_t> raw(stride * height);
+  for (unsigned y = 0; y < height; ++y) {
+    std::uint8_t *dst = raw.data() + y * stride;
+    const std::uint32_t *src =
+        pixels.data() + static_cast<std::size_t>(y) * width;
+    *dst++ = 0;
+    for (unsigned x = 0; x < width; ++x) {
+      for (int c = 0; c < 4; ++c)
+        *dst++ = static_cast<std::uint8_t>(channelOf(src[x], c));
+    }
+  }
+
+  // ---------- zlib stream of stored (uncompressed) deflate blocks ----------
+  // Fast and dependency-free; screenshots favour speed over file size
+  std::vector<std::uint8_t> zlib = {0x78, 0x01};
+  std::uint32_t a = 1, b = 0; // adler32
+  std::size_t offset = 0;
+  do {
+    const std::size_t size =
+        std::min<std::size_t>(65535, raw.size() - offset);
+    zlib.push_back(offset + size == raw.size() ? 1 : 0);
+    zlib.push_back(static_cast<std::uint8_t>(size));
+    zlib.push_back(static_cast<std::uint8_t>(size >> 8));
+    zlib.push_back(static_cast<std::uint8_t>(~size));
+    zlib.push_back(static_cast<std::uint8_t>(~size >> 8));
+    zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + size);
+    for (std::size_t i = offset; i < offset + size; ++i) {
+      a = (a + raw[i]) % 65521;
+      b = (b + a) % 65521;
+    }
+    offset += size;
+  } while (offset < raw.size());
+  putBE32(zlib, b << 16 | a);
+
+  // ---------- Chunks ----------
+  std::vector<std::uint8_t> header;
+  putBE32(header, width);
+  putBE32(header, height);
+  header.insert(header.end(), {8, 6, 0, 0, 0}); // 8-bit RGBA
+
+  std::vector<std::uint8_t> png = {0x89, 'P',  'N',  'G',
+                                   '\r', '\n', 0x1A, '\n'};
+  putChunk(png, "IHDR", header);
+  putChunk(png, "IDAT", zlib);
+  putChunk(png, "IEND", {});
+
+  std::ofstream out(path, std::ios::binary);
+  if (!out)
+    return false;
+  out.write(reinterpret_cast<const char *>(png.data()),
+            static_cast<std::streamsize>(png.size()));
+  return static_cast<bool>(out);
+}
@@ -0,0 +1,289 @@
+#include "../headers/stylesheet.hpp"
+#include "../headers/container.hpp"
+#include "../headers/element_index.hpp"
+#include <algorithm>
+#include <cstring>
+
+// Whether the whitespace-separated `classList` contains `cls`, without
+// splitting it into strings
+static bool hasClass(const std::string &classList, const std::string &cls) {
+  const std::size_t n = cls.size();
+  std::size_t pos = 0;
+  while ((pos = classList.find(cls, pos)) != std::string::npos) {
+    const bool startsWord =
+        pos == 0 || std::strchr(" \t\n", classList[pos - 1]) != nullptr;
+    const bool endsWord = pos + n == classList.size() ||
+                          std::strchr(" \t\n", classList[pos + n]) != nullptr;
+    if (startsWord && endsWord)
+      return true;
+    pos += n;
+  }
+  return false;
+}
+
+template <typename Fn> static void forEachElement(Element &element, Fn &fn) {
+  fn(element);
+  if (auto *container = dynamic_cast<Container *>(&element)) {
+    for (auto &ch : container->getChildren())
+      forEachElement(*ch, fn);
+  }
+}
+
+std::size_t Stylesheet::KeyHash::operator()(const Key &k) const {
+  std::hash<const void *> h;
+  std::size_t seed = h(k.type);
+  for (const void *p : {static_cast<const void *>(&k.classList.get()),
+                        static_cast<const void *>(&k.id.get()),
+                        static_cast<const void *>(&k.base.get())})
+    seed ^= h(p) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+  return seed;
+}
+
+// Every live sheet, for evictAllUnused() (UI thread only, like interning)
+static std::vector<Stylesheet *> &liveSheets() {
+  static std::vector<Stylesheet *> sheets;
+  return sheets;
+}
+
+Stylesheet::Stylesheet() { liveSheets().push_back(this); }
+
+Stylesheet::~Stylesheet() {
+  detach();
+  std::vector<Stylesheet *> &sheets = liveSheets();
+  sheets.erase(std::remove(sheets.begin(), sheets.end(), this), sheets.end());
+}
+
+// -------------------------------------------------------------
+// Rules
+// -------------------------------------------------------------
+
+Stylesheet::RuleId Stylesheet::addRule(const std::string &selector,
+                                       Declarations declarations) {
+  return addRule(nullptr, selector, std::move(declarations));
+}
+
+Stylesheet::RuleId Stylesheet::addRule(const std::type_info *type,
+                                       const std::string &selector,
+                                       Declarations declarations) {
+  Rule rule;
+  rule.type = type;
+  rule.declarations = std::move(declarations);
+
+  // Compound selector: "#id" and ".class" parts; anything else ("*", a
+  // tag name) is ignored, the type comes from the template argument
+  std::size_t pos = selector.find_first_of("#.");
+  while (pos != std::string::npos) {
+    const std::size_t end = selector.find_first_of("#. \t\n", pos + 1);
+    const std::string name = selector.substr(
+        pos + 1, end == std::string::npos ? std::string::npos : end - pos - 1);
+    if (!name.empty()) {
+      if (selector[pos] == '#')
+        rule.id = InternedString(name);
+      else
+        rule.classes.push_back(name);
+    }
+    pos = end == std::string::npos ? end : selector.find_first_of("#.", end);
+  }
+  rule.specificity = (rule.id->empty() ? 0 : 100) +
+                     10 * static_cast<int>(rule.classes.size()) +
+                     (type ? 1 : 0);
+
+  const RuleId id = rules.size();
+  if (!rule.id->empty())
+    byId[*rule.id].push_back(id);
+  else if (!rule.classes.empty())
+    byClass[rule.classes.front()].push_back(id);
+  else if (type)
+    byType[std::type_index(*type)].push_back(id);
+  else
+    universal.push_back(id);
+  rules.push_back(std::move(rule));
+
+  cache.clear();
+  restyleMatches(rules[id]);
+  return id;
+}
+
+void Stylesheet::setDeclarations(RuleId rule, Declarations declarations) {
+  if (rule >= rules.size() || !rules[rule].live)
+    return;
+  rules[rule].declarations = std::move(declarations);
+  cache.clear();
+  restyleMatches(rules[rule]);
+}
+
+void Stylesheet::removeRule(RuleId rule) {
+  if (rule >= rules.size() || !rules[rule].live)
+    return;
+  // Bucket entries stay; resolve() skips dead rules
+  rules[rule].live = false;
+  rules[rule].declarations = nullptr;
+  cache.clear();
+  restyleMatches(rules[rule]);
+}
+
+bool Stylesheet::matches(const Rule &rule, const Element &element) const {
+  if (rule.type && typeid(element) != *rule.type)
+    return false;
+  if (!rule.id->empty() && element.id != rule.id)
+    return false;
+  for (const std::string &cls : rule.classes) {
+    if (!hasClass(element.getClassName(), cls))
+      return false;
+  }
+  return true;
+}
+
+void Stylesheet::restyleMatches(const Rule &rule) {
+  if (!root)
+    return;
+
+  if (!rule.id->empty()) {
+    for (Element *element : root->getIndex().findAllById(*rule.id)) {
+      if (matches(rule, *element))
+        restyle(*element);
+    }
+    return;
+  }
+  if (!rule.classes.empty()) {
+    // Restyling leaves the index alone, so the set can be walked directly
+    for (Element *element : root->findByClass(rule.classes.front())) {
+      if (matches(rule, *element))
+        restyle(*element);
+    }
+    return;
+  }
+  auto visit = [&](Element &element) {
+    if (matches(rule, element))
+      restyle(element);
+  };
+  forEachElement(*root, visit);
+}
+
+// -------------------------------------------------------------
+// Styling
+// -------------------------------------------------------------
+
+const StyleRef &Stylesheet::resolve(Element &element) {
+  const std::type_info &type = typeid(element);
+  // The id only matters (and splits the cache) if some rule selects it
+  const bool idRules =
+      !element.getId().empty() && byId.count(element.getId()) != 0;
+  Key key{&type, element.className, idRules ? element.id : InternedString(),
+          element.baseStyle};
+
+  auto it = cache.find(key);
+  if (it != cache.end()) {
+    ++stats.cacheHits;
+    return it->second;
+  }
+  ++stats.cacheMisses;
+
+  matched.clear();
+  auto gather = [&](const std::vector<RuleId> &bucket) {
+    for (RuleId id : bucket) {
+      if (rules[id].live && matches(rules[id], element))
+        matched.push_back(id);
+    }
+  };
+  if (idRules)
+    gather(byId.find(element.getId())->second);
+  ElementIndex::forEachClass(element.getClassName(),
+                             [&](const std::string &cls) {
+                               auto found = byClass.find(cls);
+                               if (found != byClass.end())
+                                 gather(found->second);
+                             });
+  auto typed = byType.find(std::type_index(type));
+  if (typed != byType.end())
+    gather(typed->second);
+  gather(universal);
+
+  // Least specific first so the most specific rule wins; a class listed
+  // twice gathers its rules twice
+  std::sort(matched.begin(), matched.end(), [this](RuleId a, RuleId b) {
+    if (rules[a].specificity != rules[b].specificity)
+      return rules[a].specificity < rules[b].specificity;
+    return a < b;
+  });
+  matched.erase(std::unique(matched.begin(), matched.end()), matched.end());
+
+  Styles resolved = *element.baseStyle;
+  for (RuleId id : matched)
+    rules[id].declarations(resolved);
+  return cache.emplace(std::move(key), StyleRef(resolved)).first->second;
+}
+
+std::size_t Stylesheet::evictUnused() {
+  std::size_t evicted = 0;
+  for (auto it = cache.begin(); it != cache.end();) {
+    // The entry holds its result once, and again as the key's base when no
+    // rule changed anything; any other handle is an element using it
+    const StyleRef &resolved = it->second;
+    const std::uint32_t own = it->first.base == resolved ? 2 : 1;
+    if (resolved.useCount() <= own) {
+      it = cache.erase(it);
+      ++evicted;
+    } else {
+      ++it;
+    }
+  }
+  return evicted;
+}
+
+std::size_t Stylesheet::evictAllUnused() {
+  std::size_t evicted = 0;
+  for (Stylesheet *sheet : liveSheets())
+    evicted += sheet->evictUnused();
+  return evicted;
+}
+
+void Stylesheet::restyle(Element &element) {
+  if (!element.sheetStyled) {
+    element.baseStyle = element.style;
+    element.sheetStyled = true;
+  }
+  ++stats.restyled;
+  // Interned: an unchanged result is the same handle and invalidates nothing
+  element.setStyle(resolve(element));
+}
+
+void Stylesheet::restyleSubtree(Element &element) {
+  auto visit = [this](Element &e) { restyle(e); };
+  forEachElement(element, visit);
+}
+
+// -------------------------------------------------------------
+// Attaching
+// -------------------------------------------------------------
+
+void Stylesheet::attach(Container &tree) {
+  Container *top = &tree;
+  while (top->getParent())
+    top = top->getParent();
+  if (root == top)
+    return;
+
+  detach();
+  if (top->stylesheet)
+    top->stylesheet->detach();
+  root = top;
+  root->stylesheet = this;
+  restyleSubtree(*root);
+}
+
+void Stylesheet::detach() {
+  if (!root)
+    return;
+  // Elements go back to the styles set from code
+  auto visit = [](Element &element) {
+    if (!element.sheetStyled)
+      return;
+    element.sheetStyled = false;
+    element.setStyle(element.baseStyle);
+    element.baseStyle = StyleRef();
+  };
+  forEachElement(*root, visit);
+  root->stylesheet = nullptr;
+  root = nullptr;
+}
@@ -1,70 +1,81 @@
 #include "../headers/util.hpp"
 #include <SFML/Graphics.hpp>
+#include <algorithm>
 #include <cmath>
 
 namespace Util {
 
-// helper for clamping values
-static inline float clamp(float v, float min, float max) {
-  return std::max(min, std::min(max, v));
+void fitRadii(const sf::FloatRect &rect, const float radii[4],
+              float out[4]) {
+  float scale = 1.0f;
+  auto limit = [&scale](float side, float a, float b) {
+    if (a + b > side && a + b > 0.0f)
+      scale = std::min(scale, side / (a + b));
+  };
+  for (int i = 0; i < 4; ++i)
+    out[i] = std::max(0.0f, radii[i]);
+  limit(rect.width, out[0], out[1]);
+  limit(rect.width, out[3], out[2]);
+  limit(rect.height, out[0], out[3]);
+  limit(rect.height, out[1], out[2]);
+  for (int i = 0; i < 4; ++i)
+    out[i] *= scale;
 }
 
+const int segments = 12; // smoothness (points per corner - 1)
+const int outlinePoints = 4 * (segments + 1);
+
+// Clockwise outline starting at the top-left corner; writes outlinePoints
+static void roundedOutline(const sf::FloatRect &rect, const float radii[4],
+                           sf::Vector2f *points) {
+  float r[4];
+  fitRadii(rect, radii, r);
+
+  const float left = rect.left, top = rect.top;
+  const float right = rect.left + rect.width;
+  const float bottom = rect.top + rect.height;
+  const sf::Vector2f centres[4] = {{left + r[0], top + r[0]},
+                                   {right - r[1], top + r[1]},
+                                   {right - r[2], bottom - r[2]},
+                                   {left + r[3], bottom - r[3]}};
+  const float startAngles[4] = {180.0f, 270.0f, 0.0f, 90.0f};
+
+  for (int c = 0; c < 4; ++c) {
+    for (int i = 0; i <= segments; ++i) {
+      const float angle = (startAngles[c] + 90.0f * i / segments) *
+                          3.1415926f / 180.0f;
+      *points++ = {centres[c].x + std::cos(angle) * r[c],
+                   centres[c].y + std::sin(angle) * r[c]};
+    }
+  }
+}
+
+// Vertices live on the stack: no allocation per call
 void drawRoundedRect(sf::RenderTarget &target, const sf::FloatRect &rect,
                      const sf::Color &fillColor, const float radii[4]) {
   // Simplify if all radii are 0
   if (radii[0] <= 0 && radii[1] <= 0 && radii[2] <= 0 && radii[3] <= 0) {
-    sf::RectangleShape box({rect.width, rect.height});
-    box.setPosition(rect.left, rect.top);
-    box.setFillColor(fillColor);
-    target.draw(box);
+    const sf::Vertex quad[4] = {
+        {{rect.left, rect.top}, fillColor},
+        {{rect.left + rect.width, rect.top}, fillColor},
+        {{rect.left, rect.top + rect.height}, fillColor},
+        {{rect.left + rect.width, rect.top + rect.height}, fillColor}};
+    target.draw(quad, 4, sf::TriangleStrip);
     return;
   }
 
-  const int segments = 12; // smoothness
-  sf::VertexArray verts(sf::TriangleFan);
-  sf::Vector2f pos(rect.left, rect.top);
-  sf::Vector2f size(rect.width, rect.height);
-
-  sf::RenderTexture tex;
-  tex.create(static_cast<unsigned int>(rect.width),
-             static_cast<unsigned int>(rect.height));
-  tex.clear(sf::Color::Transparent);
-
-  // Helper lambda for one corner
-  auto drawCorner = [&](sf::Vector2f cornerPos, float radius,
-                        float startAngleDeg) {
-    sf::ConvexShape corner;
-    int points = std::max(3, static_cast<int>(segments * (radius > 0 ? 1 : 0)));
-    corner.setPointCount(points + 1);
-    corner.setPoint(0, sf::Vector2f(radius, radius)); // center
-    for (int i = 0; i < points; ++i) {
-      float angle =
-          (startAngleDeg + (90.0f / (points - 1)) * i) * 3.1415926f / 180.0f;
-      corner.setPoint(i + 1, {radius + std::cos(angle) * radius,
-                              radius + std::sin(angle) * radius});
-    }
-    corner.setFillColor(fillColor);
-    corner.setPosition(cornerPos);
-    tex.draw(corner);
-  };
-
-  // central rect (without rounded corners)
-  sf::RectangleShape body({size.x, size.y});
-  body.setFillColor(fillColor);
-  tex.draw(body);
-
-  // draw corners
-  drawCorner({0, 0}, radii[0], 180.0f);                     // top-left
-  drawCorner({size.x - 2 * radii[1], 0}, radii[1], 270.0f); // top-right
-  drawCorner({size.x - 2 * radii[2], size.y - 2 * radii[2]}, radii[2],
-             0.0f);                                        // bottom-right
-  drawCorner({0, size.y - 2 * radii[3]}, radii[3], 90.0f); // bottom-left
-
-  tex.display();
-
-  sf::Sprite sprite(tex.getTexture());
-  sprite.setPosition(rect.left, rect.top);
-  target.draw(sprite);
+  sf::Vector2f points[outlinePoints];
+  roundedOutline(rect, radii, points);
+
+  // Fan around the centre, closed back on the first point
+  sf::Vertex fan[outlinePoints + 2];
+  fan[0] = sf::Vertex({rect.left + rect.width / 2.0f,
+                       rect.top + rect.height / 2.0f},
+                      fillColor);
+  for (int i = 0; i < outlinePoints; ++i)
+    fan[i + 1] = sf::Vertex(points[i], fillColor);
+  fan[outlinePoints + 1] = fan[1];
+  target.draw(fan, outlinePoints + 2, sf::TriangleFan);
 }
 
 void drawRoundedBorder(sf::RenderTarget &target, const sf::FloatRect &rect,
@@ -73,31 +84,29 @@ void drawRoundedBorder(sf::RenderTarget &target, const sf::FloatRect &rect,
   if (borderWidth <= 0.0f)
     return;
 
-  // Outer
-  drawRoundedRect(target, rect, borderColor, radii);
-
   // Inner — shrunk by border width
   sf::FloatRect inner = {rect.left + borderWidth, rect.top + borderWidth,
-                         rect.width - borderWidth * 2,
-                         rect.height - borderWidth * 2};
+                         std::max(0.0f, rect.width - borderWidth * 2),
+                         std::max(0.0f, rect.height - borderWidth * 2)};
 
-  float innerRadii[4];
+  float outerRadii[4], innerRadii[4];
+  fitRadii(rect, radii, outerRadii);
   for (int i = 0; i < 4; ++i)
-    innerRadii[i] = std::max(0.0f, radii[i] - borderWidth);
+    innerRadii[i] = std::max(0.0f, outerRadii[i] - borderWidth);
 
-  // Cut out the inner shape using transparent fill
-  sf::RenderTexture mask;
-  mask.create((unsigned int)rect.width, (unsigned int)rect.height);
-  mask.clear(sf::Color::Transparent);
+  sf::Vector2f outer[outlinePoints], hole[outlinePoints];
+  roundedOutline(rect, outerRadii, outer);
+  roundedOutline(inner, innerRadii, hole);
 
-  // Draw the inner rect to erase the middle area
-  drawRoundedRect(mask, {borderWidth, borderWidth, inner.width, inner.height},
-                  sf::Color::Transparent, innerRadii);
-
-  mask.display();
-  sf::Sprite borderSprite(mask.getTexture());
-  borderSprite.setPosition(rect.left, rect.top);
-  target.draw(borderSprite);
+  // Ring as one strip alternating outer and inner points
+  sf::Vertex strip[2 * outlinePoints + 2];
+  for (int i = 0; i < outlinePoints; ++i) {
+    strip[2 * i] = sf::Vertex(outer[i], borderColor);
+    strip[2 * i + 1] = sf::Vertex(hole[i], borderColor);
+  }
+  strip[2 * outlinePoints] = strip[0];
+  strip[2 * outlinePoints + 1] = strip[1];
+  target.draw(strip, 2 * outlinePoints + 2, sf::TriangleStrip);
 }
 
 } // namespace Util
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+
+/**
+ * @brief Heap allocation counting for the zero-allocation frame check.
+ *
+ * Building with -DUI_ALLOC_GUARD (`make alloc-guard`) replaces the global
+ * operator new/delete with counting versions. Application then aborts if a
+ * steady-state frame (no pending layout, no running animation) allocates,
+ * which catches containers that regrow or temporaries creeping back into
+ * the draw path. `make alloc-test` runs the same check headless, on frames
+ * rendered into a SoftwareRasterizer. Without the flag the counter always
+ * reads zero and nothing is replaced.
+ */
+namespace AllocGuard {
+
+// True when the counting operator new is compiled in
+bool enabled();
+
+// Allocations made by the calling thread so far
+std::uint64_t count();
+
+} // namespace AllocGuard
+
+/**
+ * @brief Counts the allocations of the calling thread during its lifetime.
+ *
+ * @code
+ *   AllocationScope scope;
+ *   drawFrame();
+ *   if (scope.allocations() > 0) ...
+ * @endcode
+ */
+class AllocationScope {
+public:
+  AllocationScope() : start(AllocGuard::count()) {}
+
+  std::uint64_t allocations() const { return AllocGuard::count() - start; }
+
+private:
+  std::uint64_t start;
+};
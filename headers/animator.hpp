@@ -0,0 +1,98 @@
+#pragma once
+#include "./element.hpp"
+#include <SFML/Graphics.hpp>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Compositor-only properties an Animator can drive (see Compositing)
+enum class AnimatedProperty { TranslateX, TranslateY, Opacity, BackgroundColor };
+
+enum class Easing { Linear, EaseIn, EaseOut, EaseInOut };
+
+/**
+ * @brief Runs animations and transitions of compositor-only properties.
+ *
+ * All running animations live in one flat list and are evaluated together
+ * by tick(), once per frame. They only write Element::compositing, so no
+ * layout is ever invalidated; the cost per animation is an interpolation
+ * and a store.
+ */
+class Animator {
+public:
+  using Id = std::uint32_t;
+
+  struct Options {
+    float delay = 0.0f;        // seconds before the animation starts
+    Easing easing = Easing::EaseInOut;
+    int repeat = 0;            // extra iterations, negative = forever
+    bool alternate = false;    // reverse direction on every iteration
+  };
+
+  // Animate a scalar property (TranslateX/Y, Opacity) between two values.
+  // BackgroundColor is not a scalar: it is rejected with id 0 (see
+  // animateColor)
+  Id animate(const std::shared_ptr<Element> &target, AnimatedProperty property,
+             float from, float to, float duration, Options options);
+  Id animate(const std::shared_ptr<Element> &target, AnimatedProperty property,
+             float from, float to, float duration) {
+    return animate(target, property, from, to, duration, Options());
+  }
+
+  // Animate the background colour override
+  Id animateColor(const std::shared_ptr<Element> &target, sf::Color from,
+                  sf::Color to, float duration, Options options);
+  Id animateColor(const std::shared_ptr<Element> &target, sf::Color from,
+                  sf::Color to, float duration) {
+    return animateColor(target, from, to, duration, Options());
+  }
+
+  /**
+   * @brief Transition a property from its current value to `to`.
+   *
+   * Replaces any animation already running on the same element and
+   * property, so retargeting mid-flight continues smoothly. Scalar
+   * properties only, like animate(); colours use transitionColor().
+   */
+  Id transition(const std::shared_ptr<Element> &target,
+                AnimatedProperty property, float to, float duration,
+                Easing easing = Easing::EaseOut);
+  Id transitionColor(const std::shared_ptr<Element> &target, sf::Color to,
+                     float duration, Easing easing = Easing::EaseOut);
+
+  void cancel(Id id);
+  void cancelAll(const Element *target);
+
+  /**
+   * @brief Advance every animation by `dt` seconds and apply the values.
+   *
+   * @return true if any value was written (the frame needs a repaint).
+   */
+  bool tick(float dt);
+
+  bool isAnimating() const { return !animations.empty(); }
+  std::size_t size() const { return animations.size(); }
+
+private:
+  struct Animation {
+    Id id = 0;
+    std::weak_ptr<Element> target;
+    AnimatedProperty property = AnimatedProperty::Opacity;
+    std::array<float, 4> from = {}; // one lane for scalars, rgba for colours
+    std::array<float, 4> to = {};
+    float duration = 0.0f;
+    float elapsed = 0.0f; // negative while delayed
+    Options options;
+  };
+
+  std::vector<Animation> animations;
+  Id nextId = 1;
+
+  Id start(Animation animation);
+  void cancelProperty(const Element *target, AnimatedProperty property);
+  static std::array<float, 4> currentValue(const Element &element,
+                                           AnimatedProperty property);
+  static void apply(Element &element, AnimatedProperty property,
+                    const std::array<float, 4> &value);
+};
@@ -0,0 +1,168 @@
+#pragma once
+#include "./animator.hpp"
+#include "./container.hpp"
+#include "./draw_commands.hpp"
+#include "./frame_scheduler.hpp"
+#include "./input.hpp"
+#include "./layout_pipeline.hpp"
+#include "./mutation_queue.hpp"
+#include "./render_backend.hpp"
+#include "./renderer.hpp"
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief On-demand render loop: owns the event pump and the Renderer.
+ *
+ * A frame (layout + repaint + display) only runs when something asked for
+ * one: an event the UI reacts to, a running animation (or an element
+ * calling Renderer::requestFrame()), a due timer, a layout invalidation in
+ * the tree or an explicit requestRedraw(). Otherwise
+ * the loop blocks in waitEvent() or sleeps until the next timer, so an idle
+ * UI costs no CPU. Frames are recorded first and not presented at all if
+ * they draw exactly what the previous frame drew.
+ *
+ * Layout runs in slices within the frame budget of getScheduler(): a huge
+ * change is finished over several frames, visible parts first, and input
+ * keeps being handled in between. With LayoutMode::Pipelined, flex layout
+ * is solved on a worker thread instead (see LayoutPipeline) and the
+ * scheduler's layout step only applies it and lays out the rest.
+ *
+ * Worker threads change the tree through getMutations(); each iteration
+ * applies what they queued before laying out. Other threads cannot wake
+ * waitEvent(), so once the queue is used the loop polls instead of
+ * blocking: every 10 ms while changes keep coming, and every
+ * setMutationLatency() (50 ms by default) once nothing was queued for
+ * setMutationPollTime(). A queued change is therefore applied within that
+ * latency, and so is input arriving while the queue is quiet.
+ */
+class Application {
+public:
+  using TimerId = std::uint32_t;
+  using EventHandler = std::function<void(const sf::Event &)>;
+
+  enum class LayoutMode {
+    Sliced,   // on this thread, spread over frames by getScheduler()
+    Pipelined // flex layout on a worker thread, applied a frame later
+  };
+
+  struct Stats {
+    sf::Time active; // time spent handling events and drawing
+    sf::Time idle;   // time spent blocked or sleeping
+    std::uint64_t frames = 0;
+    std::uint64_t skippedFrames = 0; // identical to the previous frame
+    std::uint64_t wakeups = 0; // times the loop woke up
+
+    // Share of the wall time spent idle, 0..1
+    float idleRatio() const {
+      const float total = active.asSeconds() + idle.asSeconds();
+      return total > 0.0f ? idle.asSeconds() / total : 0.0f;
+    }
+  };
+
+  Application(sf::RenderWindow &window, Container &root);
+
+  Renderer &getRenderer() { return renderer; }
+  // Commands of the last frame (for debugging: getLastFrame().dump(out))
+  const FrameRecorder &getRecorder() const { return recorder; }
+  Animator &getAnimator() { return animator; }
+
+  // Called for every event, once per frame with high-frequency events
+  // coalesced (see InputDispatcher); Closed already closes the window
+  void setEventHandler(EventHandler handler) { onEvent = std::move(handler); }
+
+  // Routes pointer and key events to element handlers (Element::on)
+  InputDispatcher &getInput() { return input; }
+  // Tree changes from other threads, applied at the start of each frame
+  MutationQueue &getMutations() { return mutations; }
+  // Per-frame budget for layout and deferred jobs
+  FrameScheduler &getScheduler() { return scheduler; }
+
+  // Sliced by default; the first frame after switching waits for a full
+  // layout either way
+  void setLayoutMode(LayoutMode mode);
+  LayoutMode getLayoutMode() const {
+    return pipeline ? LayoutMode::Pipelined : LayoutMode::Sliced;
+  }
+  void setClearColor(const sf::Color &color) { clearColor = color; }
+
+  // Pace of animation frames when the window has no vsync/frame limit
+  void setFrameInterval(sf::Time interval) { frameInterval = interval; }
+
+  // Longest single wait; zero blocks in waitEvent() until input arrives
+  // (or, once getMutations() has been pushed to, until something is queued)
+  void setMaxIdleWait(sf::Time wait) { maxIdleWait = wait; }
+
+  // How long the loop keeps polling finely for queued changes after the
+  // last one, and how often it checks the queue after that
+  void setMutationPollTime(sf::Time time) { mutationPollTime = time; }
+  void setMutationLatency(sf::Time latency) { mutationLatency = latency; }
+
+  // Run `callback` once after `delay`, or every `delay` when repeating
+  TimerId setTimeout(sf::Time delay, std::function<void()> callback);
+  TimerId setInterval(sf::Time delay, std::function<void()> callback);
+  void cancelTimer(TimerId id);
+
+  // Repaint on the next iteration (for paint-only changes made by hand)
+  void requestRedraw() { redrawRequested = true; }
+
+  // Loop until the window closes
+  void run();
+
+  // One iteration: wait for work, then handle it; false once closed
+  bool step();
+
+  const Stats &getStats() const { return stats; }
+  void resetStats() { stats = Stats(); }
+
+private:
+  struct Timer {
+    TimerId id = 0;
+    sf::Time due;
+    sf::Time interval; // zero for one-shot timers
+    std::function<void()> callback;
+  };
+
+  sf::RenderWindow &window;
+  Container &root;
+  WindowBackend windowBackend;
+  Renderer renderer;
+  FrameRecorder recorder;
+  Animator animator;
+  InputDispatcher input;
+  MutationQueue mutations;
+  FrameScheduler scheduler;
+  std::unique_ptr<LayoutPipeline> pipeline; // LayoutMode::Pipelined only
+  bool layoutFlushed = false; // the first frame of a mode was laid out
+  EventHandler onEvent;
+  sf::Color clearColor = sf::Color::White;
+
+  std::vector<Timer> timers;
+  TimerId nextTimerId = 1;
+
+  sf::Clock clock;      // time since construction
+  sf::Time lastFrame;   // when the previous frame started
+  sf::Time frameInterval = sf::seconds(1.0f / 60.0f);
+  sf::Time maxIdleWait = sf::Time::Zero;
+  sf::Time mutationPollTime = sf::seconds(1.0f);
+  sf::Time mutationLatency = sf::milliseconds(50);
+  sf::Time lastMutation;           // when a new push was last noticed
+  std::uint64_t mutationsSeen = 0; // MutationQueue::pushCount() then
+  bool redrawRequested = true; // the first frame is always drawn
+  bool animating = false;      // the previous frame ran animations
+  bool frameRequested = false; // an element asked for the next frame
+  Stats stats;
+
+  TimerId addTimer(sf::Time delay, sf::Time interval,
+                   std::function<void()> callback);
+  bool hasWork() const;
+  // Block or sleep until there is work; true if `event` woke the loop
+  bool waitForWork(sf::Event &event);
+  void handleEvent(const sf::Event &event);
+  void windowEvent(const sf::Event &event);
+  void runTimers();
+  void frame();
+};
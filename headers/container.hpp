@@ -1,22 +1,55 @@
 #pragma once
 #include "./element.hpp"
+#include "./element_desc.hpp"
+#include "./element_index.hpp"
+#include "./flex_kernel.hpp"
+#include "./layout_snapshot.hpp"
 #include "./renderer.hpp"
 #include <SFML/Graphics.hpp>
 #include <algorithm>
 #include <memory>
 
-enum class JustifyContent {
-  Start,
-  Center,
-  End,
-  SpaceBetween,
-  SpaceAround,
-  SpaceEvenly
-};
+class FrameBudget;
+class FrameScheduler;
+class LayoutPipeline;
+class Stylesheet;
+
+/**
+ * @brief Incremental line breaker used by WrapMode::Wrap layouts.
+ *
+ * Children before the first invalidated index keep their line and their
+ * computedPosition. Appending or removing near the end only reflows the
+ * last line(s); a change of the available main-axis space reflows from the
+ * first line whose break actually changes.
+ */
+class WrapCache {
+public:
+  static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+  // Children from `index` onwards were inserted, removed or replaced
+  void invalidateFrom(std::size_t index) {
+    firstDirty = std::min(firstDirty, index);
+  }
 
-enum class AlignItems { Start, Center, End };
+  // Measures and places the children of `owner`
+  void arrange(Container &owner, const FlexParams &params);
 
-enum class WrapMode { NoWrap, Wrap };
+  const std::vector<WrapLine> &getLines() const { return lines; }
+
+private:
+  std::vector<WrapLine> lines;
+  std::vector<sf::Vector2f> sizes; // measured child sizes of the last pass
+  std::vector<sf::Vector2f> positions;
+  std::size_t firstDirty = 0;
+  bool hasParams = false;
+  FlexParams last;
+
+  std::size_t lineOf(std::size_t child) const;
+  std::size_t firstChangedLine(float mainLimit, float gap) const;
+  void breakLinesFrom(std::size_t line, const FlexParams &params);
+  void positionLinesFrom(std::size_t line, Container &owner,
+                         const FlexParams &params);
+};
 
 class Container : public Element {
 public:
@@ -25,198 +58,282 @@ public:
   float gap = 0.0f;
 
   explicit Container(sf::RenderWindow &wind);
-  virtual ~Container() = default;
+  // Children that outlive the container get a null parent; a root also
+  // unlinks the stylesheet and scheduler attached to it, so they may be
+  // destroyed after the tree
+  virtual ~Container();
   const std::vector<std::shared_ptr<Element>> &getChildren() const {
     return children;
   }
 
-  // PASS 1: layout + submitting absolute children
+  // PASS 1: layout + submitting absolute children. A tree whose layout a
+  // FrameScheduler or a LayoutPipeline runs is drawn as far as it got.
   void update(Renderer &renderer) override {
-    if (style.absZIndex >= 0) {
+    Container *root = getRoot();
+    if (!root->scheduler && !root->pipeline)
+      layout();
+
+    if (style->absZIndex >= 0) {
       renderer.addToGlobalDrawList(this);
       return;
     }
+    updateChildren(renderer);
+  }
 
-    arrangeChildren();
+  /**
+   * @brief Re-lay out the invalidated parts of this subtree.
+   *
+   * Only containers whose arrangement is dirty run arrangeChildren(), and
+   * only children flagged dirty are visited, so a clean tree costs nothing.
+   */
+  void layout() override;
 
-    for (auto &ch : children) {
-      ch->update(renderer);
+  bool needsLayout() const override {
+    return arrangeDirty || Element::needsLayout();
+  }
+
+  /**
+   * @brief layout(), stopping once `budget` has expired.
+   *
+   * Returns true once the subtree is laid out. Children are measured in
+   * chunks and laid out one by one, checking the budget in between; when it
+   * runs out the dirty flags of the unfinished containers are left set, so
+   * the next call resumes there. Children within the viewport go first.
+   */
+  bool layoutSlice(FrameBudget &budget);
+
+  // ---------- Transactions ----------
+  /**
+   * @brief Run `fn` with invalidation and layout deferred until it returns.
+   *
+   * Style edits made through invalidateLayout()/updateStyle() inside the
+   * batch are only recorded; the commit invalidates each touched element
+   * once and lays out the union of affected subtrees in a single pass.
+   * Batches nest and always apply to the whole tree.
+   */
+  template <typename Fn> void batch(Fn &&fn) {
+    beginBatch();
+    try {
+      fn();
+    } catch (...) {
+      commitBatch();
+      throw;
     }
+    commitBatch();
   }
 
+  void beginBatch();
+  void commitBatch();
+  bool inBatch() const;
+
+  // ---------- Layout snapshots (background layout) ----------
+  // Fill the layout inputs of this container; flex layouts override
+  virtual void describeLayout(LayoutNode & /*node*/) const {}
+
+  /**
+   * @brief Copy the layout inputs of this whole subtree into `snapshot`.
+   *
+   * Nodes are stored breadth-first; `elements` receives the element of
+   * each node. Viewport units will resolve against `viewport`. Neither the
+   * tree nor the window is touched, so disjoint trees may be captured on
+   * several threads at once.
+   */
+  void captureLayout(LayoutSnapshot &snapshot, std::vector<Element *> &elements,
+                     sf::Vector2u viewport);
+
+  /**
+   * @brief Capture what has to be laid out again, consuming the invalidations.
+   *
+   * Root only. Walks down the dirty paths like layout() and captures the
+   * flex containers that must be arranged, with their children, and below
+   * them only what may move or change size; a one-node edit captures its
+   * parent's children, not the tree. Whoever solves the snapshot is now
+   * responsible for that layout. Containers that do not describe a flex
+   * layout are added to `deferred` instead, to be laid out by the regular
+   * pass. `elements` keeps the captured elements alive until applied.
+   */
+  void captureChanges(LayoutSnapshot &snapshot, std::vector<Ptr> &elements,
+                      std::vector<Ptr> &deferred);
+
+  /**
+   * @brief Write a solved captureChanges() result back into its elements.
+   *
+   * Uncaptured subtrees are shifted along with a moved container, or
+   * invalidated if their container changed size. A captured subtree whose
+   * top was moved in the meantime is invalidated again instead.
+   */
+  void applyLayout(const LayoutResult &result,
+                   const std::vector<Ptr> &elements);
+
+  // Bumped by every child insertion, removal or move anywhere in the tree
+  std::uint64_t getStructureVersion() { return getRoot()->structureVersion; }
+  // Bumped whenever an element of the tree gets a different style
+  std::uint64_t getStyleVersion() { return getRoot()->styleVersion; }
+
   // PASS 2: draw this container and its non-abs children in relZ order
   void draw() override {
-    if (!style.visible)
+    if (!style->visible || compositing.opacity <= 0.0f)
       return;
 
+    // Translate/opacity apply to this container and its whole subtree
+    const DrawState saved = pushCompositing();
     drawSelf();
 
-    // Sort children by relZIndex for local stacking
-    std::sort(children.begin(), children.end(), [](const Ptr &a, const Ptr &b) {
-      return a->style.relZIndex < b->style.relZIndex;
-    });
-
-    for (auto &ch : children) {
-      if (ch->style.absZIndex >= 0)
+    sortDrawOrder(0, children.size());
+    for (Element *ch : drawOrder) {
+      if (ch->style->absZIndex >= 0)
         continue;
       ch->draw();
     }
+    drawState = saved;
   }
-  void addChild(std::shared_ptr<Element> child) {
-    children.push_back(child);
-    child->setParent(this);
+  // ---------- Child mutation (one invalidation per call) ----------
+  void addChild(std::shared_ptr<Element> child);
+  void insertChildren(std::size_t pos, const std::vector<Ptr> &items);
+  // Remove every child with the id (ids should be unique, but need not be)
+  void removeChild(const std::string &id);
+  void removeChildren(const std::vector<std::string> &ids);
+  void moveChild(std::size_t from, std::size_t to);
+  // Reorder so that the new i-th child is the old order[i]-th child
+  void reorderChildren(const std::vector<std::size_t> &order);
+  void clearChildren();
+
+  /**
+   * @brief Make the children match `desired` with as few changes as possible.
+   *
+   * Existing children are matched by id (unkeyed ones by position) and
+   * kept if their type matches: they are moved into place and get their
+   * style/className patched, so unchanged elements keep their measured
+   * size and, if nothing before them moved, their position. Unmatched
+   * children are removed and missing ones built; the same happens
+   * recursively for every kept container.
+   */
+  ReconcileStats reconcile(const std::vector<ElementDesc> &desired);
+
+  // ---------- Tree-wide lookup ----------
+  /**
+   * @brief The id/className index of the tree this container belongs to.
+   *
+   * Lives on the root container and is built on first use; afterwards it is
+   * maintained by the child mutation methods above.
+   */
+  ElementIndex &getIndex();
+  // The tree's index if it has been built, otherwise nullptr
+  ElementIndex *findIndex();
+
+  Element *findById(const std::string &id) { return getIndex().findById(id); }
+  const ElementIndex::ElementSet &findByClass(const std::string &className) {
+    return getIndex().findByClass(className);
   }
 
-  void removeChild(const std::string &id) {
-    children.erase(std::remove_if(children.begin(), children.end(),
-                                  [&id](const std::shared_ptr<Element> &elem) {
-                                    return elem->style.id == id;
-                                  }),
-                   children.end());
+  // Stylesheet attached to this tree (see Stylesheet::attach), or null
+  Stylesheet *getStylesheet() const;
+
+  // ---------- Scrolling hooks (see ScrollLayout) ----------
+  // Paint-only offset of the children, applied at draw and hit-test time
+  virtual sf::Vector2f getChildOffset() const { return {0.0f, 0.0f}; }
+  // Children are only visible (and hit) inside getPaddingRect()
+  virtual bool clipsChildren() const { return false; }
+  // Children [first, last) may intersect `area` (layout coordinates);
+  // all of them unless the container can tell from its arrangement
+  virtual void childrenIn(const sf::FloatRect & /*area*/, std::size_t &first,
+                          std::size_t &last) const {
+    first = 0;
+    last = children.size();
   }
 
-  void clearChildren() { children.clear(); }
-
 protected:
+  friend class Element;
+  friend class WrapCache;
+  friend class Stylesheet;
+  friend class FrameScheduler;
+  friend class LayoutPipeline;
+
   std::vector<Ptr> children;
+  std::vector<Element *> drawOrder;
+  std::vector<sf::Vector2f> layoutSizes, layoutPositions; // arrange scratch
+  WrapCache wrapCache;
+  bool arrangeDirty = true; // children must be positioned again
+
   virtual void drawSelf() = 0;
   virtual void arrangeChildren() = 0;
-};
-
-/**
- * @brief A layout container that arranges children vertically.
- *
- * Supports:
- * - gap (spacing between items)
- * - justify-content (main-axis alignment)
- * - align-items (cross-axis alignment)
- * - wrap (multi-column layout)
- */
-class VerticalLayout : public Container {
-public:
-  using Container::Container; // inherit constructor
-
-  // Layout properties
-  JustifyContent justifyContent = JustifyContent::Start;
-  AlignItems alignItems = AlignItems::Start;
-  WrapMode wrap = WrapMode::NoWrap;
-  float gap = 0.0f;
-
-  // -------------------------------------------------------------
-  // Draw background + border (container appearance)
-  // -------------------------------------------------------------
-  void drawSelf() override {
-    drawBackground(getBorderRect(), style.backgroundColor);
-    drawBorder(getBorderRect(), style.borderColor, boxModel.border[0]);
-  }
-
-  // -------------------------------------------------------------
-  // Arrange children vertically with spacing and alignment
-  // -------------------------------------------------------------
-  void arrangeChildren() override {
-    if (children.empty())
-      return;
-
-    const float containerWidth = parseUnit(style.width, Axis::Horizontal);
-    const float containerHeight = parseUnit(style.height, Axis::Vertical);
-    const float paddingLeft = boxModel.padding[3];
-    const float paddingTop = boxModel.padding[0];
-
-    float x = computedPosition.x + paddingLeft;
-    float y = computedPosition.y + paddingTop;
-
-    // ---------- Compute total height of all children ----------
-    float totalHeight = 0.0f;
-    for (auto &ch : children) {
-      totalHeight += ch->getBoxModel().computedSize.y;
-    }
-    totalHeight += gap * (children.size() - 1);
-
-    // ---------- Calculate justification ----------
-    float extraSpace = containerHeight - totalHeight;
-    float startOffset = 0.0f;
-
-    switch (justifyContent) {
-    case JustifyContent::Center:
-      startOffset = extraSpace / 2.0f;
-      break;
-    case JustifyContent::End:
-      startOffset = extraSpace;
-      break;
-    case JustifyContent::SpaceBetween:
-      if (children.size() > 1)
-        gap = extraSpace / (children.size() - 1);
-      break;
-    case JustifyContent::SpaceAround:
-      gap = extraSpace / children.size();
-      startOffset = gap / 2.0f;
-      break;
-    case JustifyContent::SpaceEvenly:
-      gap = extraSpace / (children.size() + 1);
-      startOffset = gap;
-      break;
-    default:
-      break;
-    }
-
-    y += std::max(0.0f, startOffset);
-
-    // ---------- Position children ----------
-    float columnWidth = 0.0f; // for wrapping
-    for (auto &ch : children) {
-      auto &childBox = ch->getBoxModel();
-      float cw = childBox.computedSize.x;
-      float chh = childBox.computedSize.y;
-
-      // Wrap if enabled and child exceeds container height
-      if (wrap == WrapMode::Wrap &&
-          y + chh > computedPosition.y + containerHeight - paddingTop) {
-        y = computedPosition.y + paddingTop;
-        x += columnWidth + gap;
-        columnWidth = 0.0f;
-      }
-
-      // Align items horizontally
-      float offsetX = 0.0f;
-      switch (alignItems) {
-      case AlignItems::Center:
-        offsetX = (containerWidth - cw) / 2.0f;
-        break;
-      case AlignItems::End:
-        offsetX = containerWidth - cw;
-        break;
-      default:
-        break;
-      }
-
-      ch->computedPosition = {x + offsetX, y};
-      y += chh + gap;
-      columnWidth = std::max(columnWidth, cw);
-    }
+  // Fill drawOrder with children [first, last) in local stacking order
+  void sortDrawOrder(std::size_t first, std::size_t last);
+  // Rest of update(): every child, unless a subclass culls them
+  virtual void updateChildren(Renderer &renderer) {
+    for (auto &ch : children)
+      ch->update(renderer);
   }
 
-  // -------------------------------------------------------------
-  // Update pass (layout + recursive update)
-  // -------------------------------------------------------------
-  void update(Renderer &renderer) override {
-    arrangeChildren();
-    Container::update(renderer); // recurse and submit absZ children
-  }
+  // Measure and place the children with the flex kernels
+  void arrangeFlex(const FlexParams &params, WrapMode wrap);
+
+  // Measured size of a child; re-measures only if it was invalidated
+  sf::Vector2f measureChild(Element &child);
+  // Move a child, scheduling its own subtree if it is a container
+  void placeChild(Element &child, const sf::Vector2f &position);
+
+  void markLayoutDirty() override;
+  void invalidateArrangement(bool resized) override;
+  // Children from `first` onwards were added, removed, moved or resized
+  void invalidateChildrenFrom(std::size_t first);
+  // Every element below this container must be measured again
+  void invalidateSubtree();
+
+private:
+  std::unique_ptr<ElementIndex> index; // only set on the root container
+  Stylesheet *stylesheet = nullptr;    // only set on the root container
+  FrameScheduler *scheduler = nullptr; // only set on the root container
+  LayoutPipeline *pipeline = nullptr;  // only set on the root container
+
+  // Root-only transaction state
+  int batchDepth = 0;
+  std::vector<Element *> pendingLayout;
+  sf::Vector2u lastViewport = {0, 0};
+  std::uint64_t structureVersion = 0;
+  std::uint64_t styleVersion = 0;
+
+  void structureChanged() { ++getRoot()->structureVersion; }
+
+  Container *getRoot();
+  // Root only: measure itself and react to viewport changes
+  void measureRoot();
+  void captureDirty(const Ptr &self, LayoutSnapshot &snapshot,
+                    std::vector<Ptr> &elements, std::vector<Ptr> &deferred);
+  void captureSubtree(const Ptr &self, LayoutSnapshot &snapshot,
+                      std::vector<Ptr> &elements, std::vector<Ptr> &deferred);
+  void translateChildren(const sf::Vector2f &delta);
+  void dropPending(Element *element);
+  void adopt(const Ptr &child, ElementIndex *treeIndex);
+  void release(const Ptr &child, ElementIndex *treeIndex);
+  void renumberFrom(std::size_t first);
+  void reconcileChildren(const std::vector<ElementDesc> &desired,
+                         ReconcileStats &stats);
+  Ptr build(const ElementDesc &desc, ReconcileStats &stats);
+  void patch(Element &element, const ElementDesc &desc, ReconcileStats &stats);
 };
 
 /**
- * @brief A layout container that arranges children horizontally.
+ * @brief A layout container that arranges children along one axis.
  *
  * Supports:
  * - gap (spacing between items)
  * - justify-content (main-axis alignment)
  * - align-items (cross-axis alignment)
- * - wrap (multi-line layout)
+ * - wrap (multi-line / multi-column layout)
+ *
+ * The main axis is a template parameter; the flex kernels pick a
+ * specialization for the axis and alignment once per arrangement, so the
+ * per-child loops do not branch on the layout properties.
  */
-class HorizontalLayout : public Container {
+template <Axis MainAxis> class FlexLayout : public Container {
 public:
   using Container::Container; // inherit constructor
 
+  static constexpr Axis mainAxis = MainAxis;
+  static constexpr Axis crossAxis =
+      MainAxis == Axis::Horizontal ? Axis::Vertical : Axis::Horizontal;
+
   // Layout properties
   JustifyContent justifyContent = JustifyContent::Start;
   AlignItems alignItems = AlignItems::Start;
@@ -227,100 +344,41 @@ public:
   // Draw background + border (container appearance)
   // -------------------------------------------------------------
   void drawSelf() override {
-    drawBackground(getBorderRect(), style.backgroundColor);
-    drawBorder(getBorderRect(), style.borderColor, boxModel.border[0]);
+    drawBackground(getBorderRect(), getBackgroundColor());
+    drawBorder(getBorderRect(), style->borderColor, boxModel.border[0]);
   }
 
   // -------------------------------------------------------------
-  // Arrange children horizontally with spacing and alignment
+  // Arrange children along the main axis with spacing and alignment
   // -------------------------------------------------------------
   void arrangeChildren() override {
-    if (children.empty())
-      return;
-
-    const float containerWidth = parseUnit(style.width, Axis::Horizontal);
-    const float containerHeight = parseUnit(style.height, Axis::Vertical);
-    const float paddingLeft = boxModel.padding[3];
-    const float paddingTop = boxModel.padding[0];
-
-    float x = computedPosition.x + paddingLeft;
-    float y = computedPosition.y + paddingTop;
-
-    // ---------- Compute total width of all children ----------
-    float totalWidth = 0.0f;
-    for (auto &ch : children) {
-      totalWidth += ch->getBoxModel().computedSize.x;
-    }
-    totalWidth += gap * (children.size() - 1);
-
-    // ---------- Calculate justification ----------
-    float extraSpace = containerWidth - totalWidth;
-    float startOffset = 0.0f;
-
-    switch (justifyContent) {
-    case JustifyContent::Center:
-      startOffset = extraSpace / 2.0f;
-      break;
-    case JustifyContent::End:
-      startOffset = extraSpace;
-      break;
-    case JustifyContent::SpaceBetween:
-      if (children.size() > 1)
-        gap = extraSpace / (children.size() - 1);
-      break;
-    case JustifyContent::SpaceAround:
-      gap = extraSpace / children.size();
-      startOffset = gap / 2.0f;
-      break;
-    case JustifyContent::SpaceEvenly:
-      gap = extraSpace / (children.size() + 1);
-      startOffset = gap;
-      break;
-    default:
-      break;
-    }
+    const sf::Vector2f content = getContentSize();
+    const bool horizontal = MainAxis == Axis::Horizontal;
+    arrangeFlex({MainAxis,
+                 {computedPosition.x + boxModel.padding[3],
+                  computedPosition.y + boxModel.padding[0]},
+                 horizontal ? content.x : content.y,
+                 horizontal ? content.y : content.x,
+                 gap,
+                 justifyContent,
+                 alignItems},
+                wrap);
+  }
 
-    x += std::max(0.0f, startOffset);
-
-    // ---------- Position children ----------
-    float lineHeight = 0.0f; // for wrapping
-    for (auto &ch : children) {
-      auto &childBox = ch->getBoxModel();
-      float cw = childBox.computedSize.x;
-      float chh = childBox.computedSize.y;
-
-      // Wrap if enabled and child exceeds container width
-      if (wrap == WrapMode::Wrap &&
-          x + cw > computedPosition.x + containerWidth - paddingLeft) {
-        x = computedPosition.x + paddingLeft;
-        y += lineHeight + gap;
-        lineHeight = 0.0f;
-      }
-
-      // Align items vertically
-      float offsetY = 0.0f;
-      switch (alignItems) {
-      case AlignItems::Center:
-        offsetY = (containerHeight - chh) / 2.0f;
-        break;
-      case AlignItems::End:
-        offsetY = containerHeight - chh;
-        break;
-      default:
-        break;
-      }
-
-      ch->computedPosition = {x, y + offsetY};
-      x += cw + gap;
-      lineHeight = std::max(lineHeight, chh);
-    }
+  void describeLayout(LayoutNode &node) const override {
+    node.flex = true;
+    node.wrap = wrap;
+    node.flexParams = {MainAxis, {}, 0.0f, 0.0f,
+                       gap, justifyContent, alignItems};
   }
 
-  // -------------------------------------------------------------
-  // Update pass (layout + recursive update)
-  // -------------------------------------------------------------
-  void update(Renderer &renderer) override {
-    arrangeChildren();
-    Container::update(renderer); // recurse and submit absZ children
+  // describeLayout() of a default-constructed FlexLayout (see ElementDesc);
+  // the other layout properties default like LayoutNode's
+  static void describeDefaults(LayoutNode &node) {
+    node.flex = true;
+    node.flexParams.mainAxis = MainAxis;
   }
 };
+
+using HorizontalLayout = FlexLayout<Axis::Horizontal>;
+using VerticalLayout = FlexLayout<Axis::Vertical>;
@@ -0,0 +1,122 @@
+#pragma once
+#include "./render_backend.hpp"
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <ostream>
+#include <type_traits>
+#include <vector>
+
+enum class DrawOp : std::uint8_t {
+  Clear,
+  FillRect,
+  StrokeRect,
+  FillRoundedRect,
+  StrokeRoundedRect,
+  PushClip,
+  PopClip,
+  Layer
+};
+
+/**
+ * @brief One recorded drawing primitive.
+ *
+ * Plain old data with no implicit padding, so two lists can be compared
+ * with memcmp. Fields a command does not use stay zero.
+ */
+struct DrawCommand {
+  DrawOp op = DrawOp::Clear;
+  std::uint8_t reserved[3] = {0, 0, 0};
+  std::uint32_t color = 0; // sf::Color::toInteger()
+  float rect[4] = {0.0f, 0.0f, 0.0f, 0.0f}; // left, top, width, height
+  float radii[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+  float thickness = 0.0f;
+  std::int32_t layer = 0;
+};
+
+static_assert(std::is_trivially_copyable<DrawCommand>::value,
+              "DrawCommand must stay POD");
+static_assert(sizeof(DrawCommand) == 48, "DrawCommand must have no padding");
+
+/**
+ * @brief Render backend that records commands instead of drawing.
+ *
+ * A frame is recorded once (see renderFrame()) and then replayed into the
+ * real backend. Comparing with the previous frame's list tells whether
+ * anything visible changed and, if so, which area must be repainted.
+ */
+class DrawCommandList : public RenderBackend {
+public:
+  // Size reported to the recorded frame (viewport units resolve against it)
+  void setSize(sf::Vector2u newSize) { size = newSize; }
+  sf::Vector2u getSize() const override { return size; }
+
+  void clear(const sf::Color &color) override;
+  void fillRect(const sf::FloatRect &rect, const sf::Color &color) override;
+  void strokeRect(const sf::FloatRect &rect, const sf::Color &color,
+                  float thickness) override;
+  void fillRoundedRect(const sf::FloatRect &rect, const sf::Color &color,
+                       const float radii[4]) override;
+  void strokeRoundedRect(const sf::FloatRect &rect, const sf::Color &color,
+                         const float radii[4], float thickness) override;
+  void pushClip(const sf::FloatRect &rect) override;
+  void popClip() override;
+  void beginLayer(int z) override;
+
+  // Forget the commands but keep the capacity
+  void reset() { commands.clear(); }
+
+  const std::vector<DrawCommand> &getCommands() const { return commands; }
+  std::size_t count() const { return commands.size(); }
+
+  // Byte-identical to `other`
+  bool sameAs(const DrawCommandList &other) const;
+
+  /**
+   * @brief Area whose pixels may differ from a frame drawn from `previous`.
+   *
+   * Union of the bounds of every command that differs between the two
+   * lists (both versions). Empty if the lists are identical.
+   */
+  sf::FloatRect damage(const DrawCommandList &previous) const;
+
+  void replay(RenderBackend &backend) const;
+  // Replay clipped to `area`, for a backend that kept the previous frame
+  void replay(RenderBackend &backend, const sf::FloatRect &area) const;
+
+  // One line per command, e.g. "fillRect 0 0 100 50 #ff0000ff"
+  void dump(std::ostream &out) const;
+
+private:
+  std::vector<DrawCommand> commands;
+  sf::Vector2u size = {0, 0};
+
+  DrawCommand &push(DrawOp op, const sf::FloatRect &rect,
+                    const sf::Color &color);
+};
+
+/**
+ * @brief Records each frame and replays it only if it changed.
+ *
+ * Keeps the last two command lists. A frame identical to the previous one
+ * is not replayed at all; into a backend that keeps its pixels between
+ * frames (retained, e.g. SoftwareRasterizer) only the damaged area is
+ * repainted.
+ */
+class FrameRecorder {
+public:
+  enum class Result { Skipped, Partial, Full };
+
+  Result present(RenderBackend &target, Container &root, Renderer &renderer,
+                 const sf::Color &clearColor, bool retained);
+
+  // Commands of the last presented frame
+  const DrawCommandList &getLastFrame() const { return frames[current]; }
+
+  // Next present() replays the whole frame
+  void invalidate() { hasPrevious = false; }
+
+private:
+  DrawCommandList frames[2];
+  int current = 0;
+  bool hasPrevious = false;
+};
@@ -1,18 +1,32 @@
 #pragma once
+#include "./input_event.hpp"
+#include "./intern.hpp"
 #include "./renderer.hpp"
 #include <SFML/Graphics.hpp>
 #include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 using uint = unsigned int;
 
 class Container;
+class RenderBackend;
 
+/**
+ * @brief Style values of an element.
+ *
+ * Elements do not embed this struct: they hold a StyleRef to an interned,
+ * immutable copy that is shared by every element with identical styles.
+ * Edits go through Element::updateStyle (copy-on-write). The per-element
+ * id and className live on Element as interned strings.
+ */
 struct Styles {
-  std::string id = "";
   std::string width = "0";
   std::string height = "0";
-  std::string className = "";
   std::string border[4] = {"0", "0", "0", "0"};
   std::string margin[4] = {"0", "0", "0", "0"};
   std::string padding[4] = {"0", "0", "0", "0"};
@@ -24,7 +38,46 @@ struct Styles {
 
   int relZIndex = 0;  // local stacking
   int absZIndex = -1; // global stacking (negative = disabled)
+
+  // GridLayout placement: 1-based start line, 0 = auto placement
+  int gridColumn = 0;
+  int gridRow = 0;
+  int gridColumnSpan = 1;
+  int gridRowSpan = 1;
+};
+
+bool operator==(const Styles &a, const Styles &b);
+
+namespace std {
+template <> struct hash<Styles> {
+  std::size_t operator()(const Styles &s) const;
 };
+} // namespace std
+
+using StyleRef = Interned<Styles>;
+
+/**
+ * @brief Per-node style memory, embedded strings vs. interned blocks.
+ *
+ * "Before" is the old layout with every Styles field (id and className
+ * included) stored inline in each element; heap blocks of long strings are
+ * not counted. "After" is the handles each element holds plus its share of
+ * the interned style blocks and strings.
+ */
+struct StyleMemoryReport {
+  std::size_t nodes = 0;
+  std::size_t bytesPerNodeBefore = 0;
+  std::size_t bytesPerNodeAfter = 0;
+  std::size_t styleBlocks = 0;     // distinct interned Styles
+  std::size_t internedStrings = 0; // distinct ids / class names
+  std::size_t poolBytes = 0;       // memory held by both pools
+};
+
+StyleMemoryReport styleMemoryReport(std::size_t nodes);
+
+// Free interned styles and strings no element references any more, after
+// dropping the stylesheet cache entries that only pin them
+std::size_t collectUnusedStyles();
 
 struct BoxModel {
   // NOTE:           top right bottom left
@@ -32,10 +85,31 @@ struct BoxModel {
   std::array<float, 4> margin = {0.0f, 0.0f, 0.0f, 0.0f};
   std::array<float, 4> padding = {0.0f, 0.0f, 0.0f, 0.0f};
   sf::Vector2f computedSize = {0.0f, 0.0f}; // {width, height}
+  sf::Vector2f contentSize = {0.0f, 0.0f};  // without padding and border
 };
 
 enum class Axis { Horizontal, Vertical };
 
+/**
+ * @brief Paint-only properties applied on top of the computed layout.
+ *
+ * Changing these never invalidates layout: translate is added to
+ * computedPosition at draw time and opacity multiplies the alpha of the
+ * whole subtree. Driven by Animator, but may be set directly as well.
+ */
+struct Compositing {
+  sf::Vector2f translate = {0.0f, 0.0f};
+  float opacity = 1.0f;
+  bool overrideBackground = false; // use backgroundColor below
+  sf::Color backgroundColor = sf::Color::Transparent;
+};
+
+// Accumulated compositing of the ancestors of the element being drawn
+struct DrawState {
+  sf::Vector2f offset = {0.0f, 0.0f};
+  float opacity = 1.0f;
+};
+
 class Element {
 public:
   explicit Element(sf::RenderWindow &wind);
@@ -47,8 +121,25 @@ public:
   const BoxModel getBoxModel();
   float parseUnit(const std::string &unit, Axis axis) const;
 
+  // Window-free unit resolution; percentages resolve against
+  // `percentBase` (the parent's content size, null for a root)
+  static float resolveUnit(const std::string &unit, Axis axis,
+                           const sf::Vector2f *percentBase,
+                           sf::Vector2u viewport);
+  static BoxModel computeBoxModel(const Styles &styles,
+                                  const sf::Vector2f *percentBase,
+                                  sf::Vector2u viewport);
+
+  // Size viewport units resolve against: the window, unless overridden
+  sf::Vector2u getViewportSize() const {
+    return viewportOverride.x || viewportOverride.y ? viewportOverride
+                                                    : window.getSize();
+  }
+
   // Get computed positions including margins/padding
   sf::Vector2f getContentSize() const;
+  // Content size the last measurement gave; what children's % resolve to
+  sf::Vector2f getMeasuredContentSize() const;
   sf::FloatRect getContentRect() const;
   sf::Vector2f getContentPosition() const;
 
@@ -60,10 +151,53 @@ public:
   Container *getParent() const { return parent; }
   void setParent(Container *newParent) { parent = newParent; }
 
+  // Position of this element in its parent's children
+  std::size_t getIndexInParent() const { return indexInParent; }
+
+  // Interned id and className; setters keep the tree's index in sync
+  const std::string &getId() const { return *id; }
+  const std::string &getClassName() const { return *className; }
+  void setId(const std::string &newId);
+  void setClassName(const std::string &newClassName);
+
+  /**
+   * @brief Mark this element's box as needing a new layout pass.
+   *
+   * Call after editing `style` of an element that is already in a tree; the
+   * next update() re-lays out only the invalidated parts. Inside
+   * Container::batch the call is just recorded and applied once at commit.
+   */
+  void invalidateLayout();
+
+  // Copy-on-write style edit, invalidating once, e.g.
+  // el->updateStyle([](Styles &s) { s.width = "50%"; });
+  // Under a Stylesheet this edits the base its rules are applied to.
+  template <typename Fn> void updateStyle(Fn &&fn) {
+    Styles edited = getBaseStyle();
+    fn(edited);
+    setBaseStyle(StyleRef(edited));
+  }
+
+  // Style set from code: `style` itself, or the base under the rules once
+  // a Stylesheet has styled this element
+  const Styles &getBaseStyle() const {
+    return sheetStyled ? *baseStyle : *style;
+  }
+  void setBaseStyle(const StyleRef &newStyle);
+
+  // Share an already interned block; invalidates only if it differs.
+  // Sets the final style, bypassing any stylesheet until its next restyle.
+  void setStyle(const StyleRef &newStyle);
+
+  virtual bool needsLayout() const { return layoutDirty || subtreeDirty; }
+
+  // Lay out dirty descendants; leaves are measured by their parent
+  virtual void layout() {}
+
   // PASS 1: update/layout. This should submit only absolute elements
   virtual void update(Renderer &renderer) {
     // Default: if element is absolute, submit it for later drawing
-    if (style.absZIndex >= 0) {
+    if (style->absZIndex >= 0) {
       renderer.addToGlobalDrawList(this);
       return; // don't recurse for absolute elements (they escape local
               // stacking)
@@ -71,13 +205,83 @@ public:
     // otherwise default does nothing; containers override to handle children
   }
 
-  Styles style;
+  StyleRef style; // read-only; edit with updateStyle()/setStyle()
   BoxModel boxModel;
   sf::Vector2f computedPosition = {0.0f, 0.0f};
+  Compositing compositing;
+
+  // Background colour after compositing overrides
+  const sf::Color &getBackgroundColor() const {
+    return compositing.overrideBackground ? compositing.backgroundColor
+                                          : style->backgroundColor;
+  }
+
+  // Compositing inherited from all ancestors (for elements drawn out of
+  // tree order, e.g. absolute z-index overlays)
+  DrawState inheritedDrawState() const;
+
+  // ---------- Input (routed by InputDispatcher) ----------
+  using InputHandler = std::function<void(InputEvent &)>;
+
+  // Call `handler` for events of `type` targeting this element or,
+  // if they bubble, any of its descendants
+  void on(InputEvent::Type type, InputHandler handler);
+  bool hasInputHandlers() const { return inputHandlers != nullptr; }
+  // Run this element's handlers for `event`; true if any ran without
+  // calling InputEvent::ignore()
+  bool handleInput(InputEvent &event);
+
+  // Pointer is over this element or a descendant
+  bool isHovered() const { return inputState & hoveredBit; }
+  // Pointer was pressed on this element or a descendant and not released
+  bool isActive() const { return inputState & activeBit; }
+
+  // Offset and opacity applied by the draw helpers; set per subtree
+  static DrawState drawState;
+
+  // Where the draw helpers draw; null draws to the element's window
+  static RenderBackend *backend;
+  // Viewport size for headless rendering; {0, 0} uses the window size
+  static sf::Vector2u viewportOverride;
 
 protected:
+  friend class Container;
+  friend class InputDispatcher;
+  friend class Stylesheet;
+
   sf::RenderWindow &window;
   Container *parent = nullptr;
+  std::size_t indexInParent = 0;
+  InternedString id;
+  InternedString className;
+
+  // Invalidation state, see invalidateLayout()
+  bool layoutDirty = true;    // own box must be measured again
+  bool subtreeDirty = false;  // some child needs a layout visit
+  bool layoutPending = false; // recorded in an open batch
+
+  // Input state; handlers are allocated only for elements that use them
+  static constexpr std::uint8_t hoveredBit = 1, activeBit = 2;
+  std::uint8_t inputState = 0;
+
+  // Set once a Stylesheet styled this element; `style` is then the base
+  // with the matching rules applied
+  bool sheetStyled = false;
+  StyleRef baseStyle;
+  std::unique_ptr<std::vector<std::pair<InputEvent::Type, InputHandler>>>
+      inputHandlers;
+
+  virtual void markLayoutDirty();
+  // Called by the parent after measuring or moving this element
+  virtual void invalidateArrangement(bool /*resized*/) {}
+
+  // Enter this element's compositing; returns the state to restore
+  DrawState pushCompositing() {
+    DrawState saved = drawState;
+    drawState.offset += compositing.translate;
+    drawState.opacity *= compositing.opacity;
+    return saved;
+  }
 
   // Helper methods for drawing box model
   void drawBackground(const sf::FloatRect &rect, const sf::Color &color);
@@ -0,0 +1,72 @@
+#pragma once
+#include "./element.hpp"
+#include <SFML/Graphics.hpp>
+#include <memory>
+#include <typeinfo>
+#include <vector>
+
+struct LayoutNode;
+
+/**
+ * @brief Desired state of one element, the input of Container::reconcile().
+ *
+ * `id` is the reconciliation key: an existing child with the same id (and
+ * type) is kept and patched instead of rebuilt. Children without an id
+ * are matched by position among the unkeyed children. id, className and
+ * style are interned, so comparing them with the live element is a
+ * pointer comparison.
+ *
+ * A description also lays out without a window (see captureLayout() in
+ * layout_snapshot.hpp): `describe` fills the layout inputs a
+ * default-constructed element of the type would report, and is null for
+ * types whose children are not flex-arranged.
+ *
+ * @code
+ *   std::vector<ElementDesc> rows;
+ *   for (const Row &row : table)
+ *     rows.push_back(ElementDesc::of<HorizontalLayout>(row.key, rowStyle));
+ *   tableContainer->reconcile(rows);
+ * @endcode
+ */
+struct ElementDesc {
+  using Factory = std::shared_ptr<Element> (*)(sf::RenderWindow &);
+  using Describe = void (*)(LayoutNode &);
+
+  const std::type_info *type = nullptr; // dynamic type of the element
+  Factory create = nullptr;             // builds it if nothing matches
+  Describe describe = nullptr;          // T::describeDefaults, if any
+  InternedString id;
+  InternedString className;
+  StyleRef style;
+  std::vector<ElementDesc> children;
+
+  template <typename T>
+  static ElementDesc of(const std::string &id, const StyleRef &style,
+                        std::vector<ElementDesc> children = {}) {
+    ElementDesc desc;
+    desc.type = &typeid(T);
+    desc.create = [](sf::RenderWindow &window) -> std::shared_ptr<Element> {
+      return std::make_shared<T>(window);
+    };
+    desc.describe = describerOf<T>(0);
+    desc.id = InternedString(id);
+    desc.style = style;
+    desc.children = std::move(children);
+    return desc;
+  }
+
+  // &T::describeDefaults when T declares one, null otherwise
+  template <typename T>
+  static auto describerOf(int) -> decltype(&T::describeDefaults) {
+    return &T::describeDefaults;
+  }
+  template <typename T> static Describe describerOf(...) { return nullptr; }
+};
+
+// What a reconciliation changed, summed over the whole subtree
+struct ReconcileStats {
+  std::size_t created = 0;  // elements built from a description
+  std::size_t removed = 0;  // children dropped (with their subtrees)
+  std::size_t moved = 0;    // kept children that changed relative order
+  std::size_t restyled = 0; // kept elements whose style/className changed
+};
@@ -0,0 +1,58 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+class Element;
+
+/**
+ * @brief Tree-wide lookup of elements by id and className.
+ *
+ * Owned by the root container of a tree and kept up to date by
+ * Container::addChild/removeChild and the bulk child mutation methods.
+ * Ids are expected to be unique within a tree, but duplicates are kept:
+ * findById() resolves to the one registered last and findAllById() lists
+ * all of them. className may hold several whitespace-separated classes,
+ * each of which is indexed.
+ */
+class ElementIndex {
+public:
+  using ElementSet = std::unordered_set<Element *>;
+  using ElementList = std::vector<Element *>;
+
+  void add(Element *element);
+  void remove(Element *element);
+
+  // Register / unregister an element and all of its descendants
+  void addSubtree(Element *element);
+  void removeSubtree(Element *element);
+
+  Element *findById(const std::string &id) const;
+  // Every element with this id, in registration order
+  const ElementList &findAllById(const std::string &id) const;
+  const ElementSet &findByClass(const std::string &className) const;
+
+  std::size_t size() const { return byId.size(); }
+  void clear();
+
+  // Calls fn(const std::string&) for every class in a className string
+  template <typename Fn>
+  static void forEachClass(const std::string &className, Fn &&fn) {
+    std::size_t pos = 0;
+    while (pos < className.size()) {
+      std::size_t begin = className.find_first_not_of(" \t\n", pos);
+      if (begin == std::string::npos)
+        break;
+      std::size_t end = className.find_first_of(" \t\n", begin);
+      if (end == std::string::npos)
+        end = className.size();
+      fn(className.substr(begin, end - begin));
+      pos = end;
+    }
+  }
+
+private:
+  std::unordered_map<std::string, ElementList> byId;
+  std::unordered_map<std::string, ElementSet> byClass;
+};
@@ -0,0 +1,69 @@
+#pragma once
+#include "./element.hpp"
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <vector>
+
+enum class JustifyContent {
+  Start,
+  Center,
+  End,
+  SpaceBetween,
+  SpaceAround,
+  SpaceEvenly
+};
+
+enum class AlignItems { Start, Center, End };
+
+enum class WrapMode { NoWrap, Wrap };
+
+/**
+ * @brief One line (row or column) of a wrapping container.
+ *
+ * Stores the index of the first child on the line, how many children it
+ * holds and its extents, so the line-break structure can be kept between
+ * frames and only the lines affected by a change are rebuilt.
+ */
+struct WrapLine {
+  std::size_t start = 0;    // index of the first child on this line
+  std::size_t count = 0;    // number of children on this line
+  float mainExtent = 0.0f;  // children + gaps along the main axis
+  float crossExtent = 0.0f; // largest child along the cross axis
+  float crossOffset = 0.0f; // distance of the line from the content origin
+};
+
+struct FlexParams {
+  Axis mainAxis = Axis::Horizontal;
+  sf::Vector2f origin = {0.0f, 0.0f}; // top-left of the content area
+  float mainLimit = 0.0f;             // content size along the main axis
+  float crossLimit = 0.0f;            // content size along the cross axis
+  float gap = 0.0f;
+  JustifyContent justify = JustifyContent::Start;
+  AlignItems align = AlignItems::Start;
+};
+
+/**
+ * @brief Window-free flex arrangement over plain arrays.
+ *
+ * Sizes in, positions out. Shared by the element layouts, the wrap cache
+ * and the snapshot solver used for background layout.
+ */
+namespace Flex {
+
+// Place `count` items on a single line (WrapMode::NoWrap); items are aligned
+// within params.crossLimit
+void arrangeLine(const sf::Vector2f *sizes, std::size_t count,
+                 const FlexParams &params, sf::Vector2f *positions);
+
+// Greedily break sizes[begin, end) into lines appended to `lines`; the first
+// new line starts at `crossOffset`
+void breakLines(const sf::Vector2f *sizes, std::size_t begin, std::size_t end,
+                const FlexParams &params, float crossOffset,
+                std::vector<WrapLine> &lines);
+
+// Place the items of one wrapped line, justified within params.mainLimit and
+// aligned within the line; writes positions[line.start, line.start + count)
+void arrangeWrappedLine(const WrapLine &line, const sf::Vector2f *sizes,
+                        const FlexParams &params, sf::Vector2f *positions);
+
+} // namespace Flex
@@ -0,0 +1,121 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+class Container;
+
+/**
+ * @brief Time left for the work of one frame.
+ *
+ * Work checks expired() between units it cannot split (arranging one
+ * container, one step of a job) and returns when it is true.
+ */
+class FrameBudget {
+public:
+  explicit FrameBudget(sf::Time limit) : limit(limit) {}
+
+  bool expired() const { return clock.getElapsedTime() >= limit; }
+  sf::Time elapsed() const { return clock.getElapsedTime(); }
+  sf::Time remaining() const {
+    const sf::Time left = limit - clock.getElapsedTime();
+    return left > sf::Time::Zero ? left : sf::Time::Zero;
+  }
+
+private:
+  sf::Clock clock;
+  sf::Time limit;
+};
+
+/**
+ * @brief Spreads layout and deferred work over frames within a time budget.
+ *
+ * Once attached, the tree is no longer laid out in full by update():
+ * every frame runFrame() lays it out in slices (Container::layoutSlice)
+ * until the budget is spent, and the frame is drawn with whatever is
+ * done. The slice resumes next frame where it stopped; the continuation
+ * is the tree's own dirty flags, so changes made in between are simply
+ * folded in. Children on screen are laid out before the ones off screen.
+ *
+ * Deferred jobs (building a subtree in chunks, uploading textures, filling
+ * caches) run in the same budget. A job is called repeatedly with the
+ * budget and returns true once finished, so it can keep its own progress
+ * and stop early, e.g.
+ *
+ *   scheduler.schedule([next = 0](FrameBudget &budget) mutable {
+ *     while (next < rows.size() && !budget.expired())
+ *       list->addChild(makeRow(rows[next++]));
+ *     return next == rows.size();
+ *   });
+ *
+ * Each frame runs High jobs, then layout, then Normal and Idle jobs; at
+ * least one unit of layout and of High work always runs, so a tiny budget
+ * cannot stall them.
+ *
+ * If the tree has a LayoutPipeline, its sync() is the layout step: flex
+ * layout is solved on the worker and only the containers it defers are
+ * laid out here, within the budget.
+ */
+class FrameScheduler {
+public:
+  enum class Priority { High, Normal, Idle };
+  using JobId = std::uint32_t;
+  using Job = std::function<bool(FrameBudget &)>;
+
+  struct Stats {
+    std::uint64_t frames = 0;
+    std::uint64_t unfinishedFrames = 0; // ended with work left over
+    std::uint64_t jobSteps = 0;
+  };
+
+  FrameScheduler() = default;
+  ~FrameScheduler();
+
+  FrameScheduler(const FrameScheduler &) = delete;
+  FrameScheduler &operator=(const FrameScheduler &) = delete;
+
+  // Take over the layout of `root`'s tree
+  void attach(Container &root);
+  void detach();
+
+  void setBudget(sf::Time newBudget) { budget = newBudget; }
+  sf::Time getBudget() const { return budget; }
+
+  JobId schedule(Job job, Priority priority = Priority::Normal);
+  void cancel(JobId id);
+
+  /**
+   * @brief Do this frame's share of layout and jobs.
+   *
+   * Returns true if nothing is left for later frames.
+   */
+  bool runFrame();
+
+  // Layout or jobs are pending
+  bool hasWork() const;
+
+  const Stats &getStats() const { return stats; }
+
+private:
+  friend class Container; // forgets `root` when the tree is destroyed
+
+  struct Entry {
+    JobId id = 0;
+    Job job;
+    bool done = false; // finished or cancelled; erased after the frame
+  };
+
+  Container *root = nullptr;
+  sf::Time budget = sf::milliseconds(8);
+  std::vector<Entry> jobs[3]; // by Priority
+  std::vector<std::pair<Priority, Entry>> incoming; // scheduled while running
+  JobId nextId = 1;
+  bool running = false;
+  Stats stats;
+
+  // Run the jobs of one priority; `force` runs one even if out of time
+  void runJobs(Priority priority, FrameBudget &frame, bool force);
+};
@@ -0,0 +1,104 @@
+#pragma once
+#include "./container.hpp"
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Size of one grid column or row.
+ *
+ * Parsed once from a string: "120px", "25%", "10vw" (any unit
+ * Element::resolveUnit knows), "2fr" (a share of the space left over by
+ * the other tracks) or "auto" (the largest child placed only in this
+ * track).
+ */
+struct GridTrack {
+  enum class Kind { Length, Fraction, Auto };
+
+  Kind kind = Kind::Auto;
+  std::string length;    // Kind::Length
+  float fraction = 0.0f; // Kind::Fraction
+
+  static GridTrack parse(const std::string &spec);
+};
+
+/**
+ * @brief A layout container that places children in the cells of a grid.
+ *
+ * Supports:
+ * - fixed / % / fr / auto column and row tracks
+ * - column and row gaps
+ * - explicit placement (Styles::gridColumn/gridRow and spans) and
+ *   row-major auto placement of everything else
+ * - alignment of each child within its cell area
+ *
+ * Children are placed directly, without intermediate row nodes, so cells
+ * line up across rows by construction. Placement, track sizing and
+ * positioning are each linear in the number of cells (times their span).
+ * Rows beyond the explicit ones are created as needed with `autoRows`;
+ * with no columns set the grid has a single "1fr" column. A child fixed
+ * to a row with no room left gets implicit "auto" columns after the
+ * others rather than overlapping a cell.
+ */
+class GridLayout : public Container {
+public:
+  using Container::Container; // inherit constructor
+
+  // Layout properties (edit the tracks with the setters below)
+  float columnGap = 0.0f;
+  float rowGap = 0.0f;
+  AlignItems justifyItems = AlignItems::Start; // horizontal, within a cell
+  AlignItems alignItems = AlignItems::Start;   // vertical, within a cell
+
+  // e.g. setColumns({"200px", "1fr", "2fr"})
+  void setColumns(const std::vector<std::string> &specs);
+  void setRows(const std::vector<std::string> &specs);
+  void setAutoRows(const std::string &spec);
+
+  const std::vector<GridTrack> &getColumns() const { return columns; }
+  const std::vector<GridTrack> &getRows() const { return rows; }
+
+  // Cell of every child from the last arrangement, in child order
+  struct Cell {
+    std::uint32_t column = 0, row = 0; // 0-based
+    std::uint32_t columnSpan = 1, rowSpan = 1;
+  };
+  const std::vector<Cell> &getCells() const { return cells; }
+
+  // Sizes of the tracks of the last arrangement
+  const std::vector<float> &getColumnSizes() const { return columnSizes; }
+  const std::vector<float> &getRowSizes() const { return rowSizes; }
+
+  // -------------------------------------------------------------
+  // Draw background + border (container appearance)
+  // -------------------------------------------------------------
+  void drawSelf() override {
+    drawBackground(getBorderRect(), getBackgroundColor());
+    drawBorder(getBorderRect(), style->borderColor, boxModel.border[0]);
+  }
+
+  void arrangeChildren() override;
+
+private:
+  std::vector<GridTrack> columns, rows;
+  GridTrack autoRows; // "auto"
+
+  // Arrangement scratch, kept between passes
+  std::vector<Cell> cells;
+  std::vector<char> occupied; // row-major, columnCount wide
+  std::vector<std::uint32_t> columnCursor; // first row worth scanning
+  std::vector<std::uint32_t> rowCursor;    // first column worth scanning
+  std::vector<float> columnSizes, rowSizes;
+  std::vector<float> columnOffsets, rowOffsets;
+  std::size_t columnCount = 1, rowCount = 0;
+
+  void placeCells();
+  bool isFree(std::uint32_t column, std::uint32_t row, std::uint32_t columnSpan,
+              std::uint32_t rowSpan);
+  void occupy(const Cell &cell);
+  void widenColumns(std::size_t count);
+  const GridTrack &trackAt(Axis axis, std::size_t index) const;
+  void sizeTracks(Axis axis, const sf::Vector2f &content, float gap,
+                  std::vector<float> &sizes, std::vector<float> &offsets);
+};
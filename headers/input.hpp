@@ -0,0 +1,102 @@
+#pragma once
+#include "./container.hpp"
+#include "./input_event.hpp"
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Routes window input to the elements of one tree.
+ *
+ * Raw SFML events are queued with push() and handled once per frame by
+ * flush(). In the queue, runs of high-frequency events collapse into one:
+ * consecutive mouse moves keep the last position, wheel deltas are
+ * summed, touch moves of a finger keep the last position, and a frame
+ * sees at most one resize. So a 1000 Hz mouse costs one hit test per
+ * frame, not one per report, and nothing here ever lays out.
+ *
+ * Hover and active state are kept as the path from the root to the
+ * element under the pointer. A new hit is diffed against the old path:
+ * only elements that left or entered get PointerLeave/PointerEnter and
+ * have their isHovered() flag changed. Everything else bubbles from the
+ * hit element through getParent().
+ *
+ * Hit testing uses the last computed layout (what is on screen) and the
+ * compositing translate. Overlays (absZIndex >= 0) are tested first,
+ * highest z first.
+ */
+class InputDispatcher {
+public:
+  struct Stats {
+    std::uint64_t received = 0;   // raw events pushed
+    std::uint64_t coalesced = 0;  // merged into a queued event
+    std::uint64_t dispatched = 0; // events delivered to at least one handler
+    std::uint64_t hitTests = 0;
+  };
+
+  explicit InputDispatcher(Container &root);
+
+  void push(const sf::Event &event);
+  bool hasPending() const { return !pending.empty(); }
+
+  /**
+   * @brief Handle every queued event.
+   *
+   * `onEvent` (optional) sees each coalesced SFML event first. Returns
+   * true if anything may need a repaint: a handler ran or the hover or
+   * active state of an element changed.
+   */
+  bool flush(const std::function<void(const sf::Event &)> &onEvent = {});
+
+  // Deepest visible element at `point` (null if outside the root)
+  Element *hitTest(sf::Vector2f point);
+
+  Element *getHovered() const;
+  Element *getFocused() const;
+
+  const Stats &getStats() const { return stats; }
+
+private:
+  // Element on a hover/active path; `alive` is empty for the root, which
+  // outlives the dispatcher
+  struct PathEntry {
+    Element *element = nullptr;
+    std::weak_ptr<Element> alive;
+  };
+  using Path = std::vector<PathEntry>;
+
+  Container &root;
+  std::vector<sf::Event> pending;
+  Stats stats;
+  bool changed = false;
+
+  Path hovered, active, scratchPath;
+  PathEntry focus;
+  sf::Vector2f pointer = {0.0f, 0.0f};
+  bool pointerInside = false;
+
+  // Overlays in hit-test order; rebuilt when the structure or a style of
+  // the tree changed (absZIndex decides what is an overlay)
+  std::vector<Element *> overlays;
+  std::uint64_t overlaysStructure = 0, overlaysStyle = 0;
+  bool overlaysBuilt = false;
+
+  void route(const sf::Event &event);
+  void pointerEvent(InputEvent::Type type, sf::Vector2f position,
+                    unsigned pointerId, sf::Mouse::Button button);
+  bool dispatch(InputEvent &event, Element *target);
+  void updateHover(const Path &now);
+  void setState(Path &path, const Path &now, std::uint8_t bit,
+                bool sendEvents);
+  bool pathFor(Element *target, Path &path);
+  // The pointer keeping `element` alive; null for a root
+  static std::shared_ptr<Element> ownerOf(Element *element);
+  static bool isAlive(const PathEntry &entry, const Container &root);
+  static Element *deepest(const Path &path, const Container &root);
+
+  void collectOverlays();
+  Element *hitDescend(Element &element, sf::Vector2f offset,
+                      sf::Vector2f point);
+};
@@ -0,0 +1,57 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+
+class Element;
+
+/**
+ * @brief A pointer, wheel or key event routed to an element.
+ *
+ * Built by InputDispatcher from (coalesced) SFML events. Events start at
+ * `target` and bubble up through getParent() until a handler calls
+ * stopPropagation(); PointerEnter/PointerLeave do not bubble. A handler
+ * that left everything as it was calls ignore(), so the event alone does
+ * not ask for a repaint.
+ */
+struct InputEvent {
+  enum class Type : std::uint8_t {
+    PointerMove,
+    PointerDown,
+    PointerUp,
+    Click, // down and up on the same element (or a common ancestor)
+    Wheel,
+    PointerEnter,
+    PointerLeave,
+    KeyDown,
+    KeyUp,
+    Text,
+    Count
+  };
+
+  Type type = Type::PointerMove;
+  sf::Vector2f position = {0.0f, 0.0f}; // pointer, in window coordinates
+  unsigned pointer = 0; // 0 = mouse, 1 + finger for touches
+  sf::Mouse::Button button = sf::Mouse::Left;
+  sf::Mouse::Wheel wheel = sf::Mouse::VerticalWheel;
+  float wheelDelta = 0.0f; // summed over the frame
+  sf::Event::KeyEvent key{};
+  std::uint32_t unicode = 0;
+
+  Element *target = nullptr;        // element the event is about
+  Element *currentTarget = nullptr; // element whose handlers run now
+
+  bool bubbles() const {
+    return type != Type::PointerEnter && type != Type::PointerLeave;
+  }
+  void stopPropagation() { stopped = true; }
+  bool propagationStopped() const { return stopped; }
+
+  // The running handler changed nothing (see Element::handleInput)
+  void ignore() { ignored = true; }
+
+private:
+  friend class Element;
+
+  bool stopped = false;
+  bool ignored = false; // reset before each handler
+};
@@ -0,0 +1,160 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+/**
+ * @brief Pool of unique, immutable, reference-counted values.
+ *
+ * Equal values share one node, so a handle is a single pointer and
+ * comparing two handles is a pointer comparison. The pool keeps one
+ * reference to every node; collect() frees the nodes no handle uses any
+ * more. Interning and collect() are meant for the UI thread; handles may be
+ * copied and read on other threads (the reference count is atomic).
+ */
+template <typename T, typename Hash = std::hash<T>> class InternPool {
+public:
+  struct Node {
+    explicit Node(const T &v) : value(v) {}
+    const T value;
+    std::atomic<std::uint32_t> refs{1}; // the pool's own reference
+  };
+
+  // Never destroyed: handles with static lifetime (a global root, a
+  // static StyleRef) may release their node after every other static
+  static InternPool &instance() {
+    static InternPool *pool = new InternPool;
+    return *pool;
+  }
+
+  ~InternPool() {
+    for (auto &entry : nodes)
+      delete entry.second;
+  }
+
+  // Returns the node holding `value`, with one reference taken
+  Node *acquire(const T &value) {
+    auto it = nodes.find(&value);
+    if (it != nodes.end()) {
+      it->second->refs.fetch_add(1, std::memory_order_relaxed);
+      return it->second;
+    }
+
+    Node *node = new Node(value);
+    node->refs.store(2, std::memory_order_relaxed);
+    nodes.emplace(&node->value, node);
+    return node;
+  }
+
+  // Free every node only the pool still references; returns how many
+  std::size_t collect() {
+    std::size_t freed = 0;
+    for (auto it = nodes.begin(); it != nodes.end();) {
+      if (it->second->refs.load(std::memory_order_acquire) == 1) {
+        delete it->second;
+        it = nodes.erase(it);
+        ++freed;
+      } else {
+        ++it;
+      }
+    }
+    return freed;
+  }
+
+  std::size_t size() const { return nodes.size(); }
+
+  // Approximate memory held by the pool (nodes, their heap data, buckets)
+  template <typename HeapBytes> std::size_t bytes(HeapBytes &&heapBytes) const {
+    std::size_t total = nodes.bucket_count() * sizeof(void *);
+    for (auto &entry : nodes) {
+      total += sizeof(Node) + heapBytes(entry.second->value);
+      total += sizeof(typename Map::value_type) + sizeof(void *); // map node
+    }
+    return total;
+  }
+
+private:
+  struct PtrHash {
+    std::size_t operator()(const T *v) const { return Hash{}(*v); }
+  };
+  struct PtrEqual {
+    bool operator()(const T *a, const T *b) const { return *a == *b; }
+  };
+  // Keys point into the nodes, so lookups need no copy of the value
+  using Map = std::unordered_map<const T *, Node *, PtrHash, PtrEqual>;
+  Map nodes;
+};
+
+/**
+ * @brief Handle to an interned value.
+ *
+ * A default-constructed handle (or one made from a default-constructed T)
+ * refers to T{} without touching the pool.
+ */
+template <typename T, typename Hash = std::hash<T>> class Interned {
+public:
+  using Pool = InternPool<T, Hash>;
+
+  Interned() = default;
+  Interned(const T &value) {
+    if (!(value == defaultValue()))
+      node = Pool::instance().acquire(value);
+  }
+  Interned(const Interned &other) : node(other.node) { retain(); }
+  Interned(Interned &&other) noexcept : node(other.node) {
+    other.node = nullptr;
+  }
+  ~Interned() { release(); }
+
+  Interned &operator=(const Interned &other) {
+    if (node != other.node) {
+      release();
+      node = other.node;
+      retain();
+    }
+    return *this;
+  }
+  Interned &operator=(Interned &&other) noexcept {
+    if (this != &other) {
+      release();
+      node = other.node;
+      other.node = nullptr;
+    }
+    return *this;
+  }
+
+  const T &get() const { return node ? node->value : defaultValue(); }
+  const T &operator*() const { return get(); }
+  const T *operator->() const { return &get(); }
+
+  // Handles sharing this value, this one included (0 for T{})
+  std::uint32_t useCount() const {
+    return node ? node->refs.load(std::memory_order_acquire) - 1 : 0;
+  }
+
+  // Equal values are always the same node
+  bool operator==(const Interned &other) const { return node == other.node; }
+  bool operator!=(const Interned &other) const { return node != other.node; }
+
+  static const T &defaultValue() {
+    static const T value{};
+    return value;
+  }
+
+private:
+  typename Pool::Node *node = nullptr;
+
+  void retain() {
+    if (node)
+      node->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+  void release() {
+    if (node)
+      node->refs.fetch_sub(1, std::memory_order_release);
+  }
+};
+
+using InternedString = Interned<std::string>;
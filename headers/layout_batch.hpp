@@ -0,0 +1,135 @@
+#pragma once
+#include "./container.hpp"
+#include "./layout_snapshot.hpp"
+#include <SFML/Graphics.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Computed box of one element in a batch result.
+ *
+ * Plain data so a whole batch is one contiguous array.
+ */
+struct BatchBox {
+  float x = 0.0f, y = 0.0f;          // computedPosition
+  float width = 0.0f, height = 0.0f; // computedSize
+  std::uint32_t parent = 0;          // index within the document (root: 0)
+  std::uint32_t solved = 0; // 0 below a container that is not flex
+};
+
+/**
+ * @brief Boxes of every document of a batch, back to back.
+ *
+ * Document d owns boxes[offsets[d]] .. boxes[offsets[d + 1]], in the
+ * breadth-first order of Container::captureLayout() (its root first).
+ * `unsolved` counts the boxes left zero because they sit below a grid,
+ * scroll or other non-flex container (see LayoutBatch).
+ */
+struct BatchResult {
+  std::vector<BatchBox> boxes;
+  std::vector<std::size_t> offsets; // documents + 1 entries
+  std::size_t unsolved = 0;
+
+  std::size_t documents() const {
+    return offsets.empty() ? 0 : offsets.size() - 1;
+  }
+  const BatchBox *begin(std::size_t doc) const {
+    return boxes.data() + offsets[doc];
+  }
+  std::size_t count(std::size_t doc) const {
+    return offsets[doc + 1] - offsets[doc];
+  }
+};
+
+/**
+ * @brief Lays out many independent trees at once on a thread pool.
+ *
+ * Meant for throughput (precomputing positions of generated documents),
+ * not for the interactive UI: nothing is drawn, no window is queried (each
+ * document brings its own viewport size) and the trees are only read, so
+ * their own layout state is left untouched. Documents are captured and
+ * solved in parallel; workers claim a few documents at a time from a
+ * shared counter, so uneven document sizes balance out.
+ *
+ * Only flex layouts are solved. GridLayout, ScrollLayout and any other
+ * container that does not describe a flex layout are sized, but their
+ * descendants come back with `solved == 0` and zero boxes; check
+ * BatchResult::unsolved and lay such documents out with Container::layout()
+ * instead.
+ *
+ * The pool and every buffer are kept between run() calls. A LayoutBatch
+ * must be used from one thread at a time.
+ */
+class LayoutBatch {
+public:
+  // `threads` includes the calling thread; 0 = hardware concurrency
+  explicit LayoutBatch(unsigned threads = 0);
+  ~LayoutBatch();
+
+  LayoutBatch(const LayoutBatch &) = delete;
+  LayoutBatch &operator=(const LayoutBatch &) = delete;
+
+  /**
+   * @brief Lay out `roots` into `result`.
+   *
+   * `viewports` holds the size viewport units resolve against, either one
+   * per root or a single size shared by all of them; if empty, each root's
+   * window is asked once on the calling thread. The roots must be distinct
+   * trees that nobody mutates during the call.
+   */
+  void run(const std::vector<Container *> &roots,
+           const std::vector<sf::Vector2u> &viewports, BatchResult &result);
+
+  // Same for documents given as descriptions; no window is needed (and
+  // without `viewports`, viewport units resolve to zero)
+  void run(const std::vector<ElementDesc> &documents,
+           const std::vector<sf::Vector2u> &viewports, BatchResult &result);
+
+  // Same for snapshots captured beforehand (their own viewports are used)
+  void run(const std::vector<LayoutSnapshot> &snapshots, BatchResult &result);
+
+  unsigned getThreadCount() const {
+    return static_cast<unsigned>(workers.size()) + 1;
+  }
+
+private:
+  // Per-thread scratch, reused across documents and runs
+  struct Scratch {
+    LayoutResult result;
+    std::vector<Element *> elements;
+    std::vector<const ElementDesc *> descs;
+  };
+
+  std::vector<std::thread> workers;
+  std::vector<Scratch> scratch; // [0] is the calling thread's
+  std::vector<LayoutSnapshot> captured;
+  std::vector<sf::Vector2u> rootViewports;
+
+  // Current job: run task(begin, end, scratch) over [0, jobSize)
+  std::function<void(std::size_t, std::size_t, Scratch &)> task;
+  std::size_t jobSize = 0;
+  std::size_t grain = 1;
+  std::atomic<std::size_t> next{0};
+
+  std::mutex mutex;
+  std::condition_variable wake, done;
+  std::uint64_t generation = 0; // bumped per job, guarded by mutex
+  unsigned busyWorkers = 0;     // guarded by mutex
+  bool stopping = false;        // guarded by mutex
+
+  void parallelFor(std::size_t count,
+                   std::function<void(std::size_t, std::size_t, Scratch &)>
+                       body);
+  void work(Scratch &local);
+  void workerLoop(unsigned index);
+  static sf::Vector2u viewportOf(const std::vector<sf::Vector2u> &viewports,
+                                 std::size_t document);
+  void solveInto(const std::vector<LayoutSnapshot> &snapshots,
+                 BatchResult &result);
+};
@@ -0,0 +1,127 @@
+#pragma once
+#include "./container.hpp"
+#include "./frame_scheduler.hpp"
+#include "./layout_snapshot.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Single-producer, single-consumer "latest value" channel.
+ *
+ * The producer fills back() and publishes it; the consumer takes the
+ * newest published value into front(). Neither side ever waits for the
+ * other: the three buffers rotate through one atomic index, and a value
+ * published twice before the consumer looks is simply replaced.
+ */
+template <typename T> class TripleBuffer {
+public:
+  // Producer side
+  T &back() { return buffers[backIndex]; }
+  void publish() {
+    backIndex =
+        shared.exchange(backIndex | freshBit, std::memory_order_acq_rel) &
+        indexMask;
+  }
+
+  // Consumer side; returns false if nothing was published since last time
+  bool acquire() {
+    if (!(shared.load(std::memory_order_acquire) & freshBit))
+      return false;
+    frontIndex = shared.exchange(frontIndex, std::memory_order_acq_rel) &
+                 indexMask;
+    return true;
+  }
+  T &front() { return buffers[frontIndex]; }
+
+  bool hasFresh() const {
+    return shared.load(std::memory_order_acquire) & freshBit;
+  }
+
+private:
+  static constexpr unsigned freshBit = 4;
+  static constexpr unsigned indexMask = 3;
+
+  T buffers[3];
+  std::atomic<unsigned> shared{1};
+  unsigned backIndex = 0;  // producer only
+  unsigned frontIndex = 2; // consumer only
+};
+
+/**
+ * @brief Runs the flex layout of a tree on a worker thread, one frame behind.
+ *
+ * Once a frame, sync() applies the layout the worker finished and, if the
+ * tree was invalidated since, hands the worker a snapshot of what changed
+ * (Container::captureChanges(): the dirty flex containers, not the whole
+ * tree). Snapshots and results travel through lock-free triple buffers, so
+ * the UI thread never blocks on the worker; the mutex below only parks an
+ * idle worker. One snapshot is in flight at a time: edits made meanwhile
+ * stay recorded in the tree and go with the next one.
+ *
+ * Containers that do not describe a flex layout (grids, scroll containers)
+ * are laid out on the UI thread by sync() itself, within its budget.
+ *
+ * While attached the tree is no longer laid out by update(). The
+ * Application uses it in LayoutMode::Pipelined, where its FrameScheduler
+ * calls sync() with the frame budget in place of the sliced layout. Used
+ * by hand, call sync() before update() each frame, and flush() when a
+ * frame must show an up-to-date layout, e.g. the very first one.
+ */
+class LayoutPipeline {
+public:
+  explicit LayoutPipeline(Container &root);
+  ~LayoutPipeline();
+
+  LayoutPipeline(const LayoutPipeline &) = delete;
+  LayoutPipeline &operator=(const LayoutPipeline &) = delete;
+
+  // Apply the finished layout, submit what changed since and lay out the
+  // deferred containers until `budget` expires (without one: all of them);
+  // returns true if a layout was applied
+  bool sync();
+  bool sync(FrameBudget &budget);
+
+  // Wait for the worker and repeat until the whole tree is laid out
+  void flush();
+
+  // A submitted snapshot has not been solved yet
+  bool busy() const {
+    return solvedSerial.load(std::memory_order_acquire) < submittedSerial;
+  }
+
+  // Anything submitted, to submit or deferred is not laid out yet
+  bool hasWork() const;
+
+  std::uint64_t getAppliedCount() const { return applied; }
+
+private:
+  Container &root;
+
+  TripleBuffer<LayoutSnapshot> snapshots; // UI thread -> worker
+  TripleBuffer<LayoutResult> results;     // worker -> UI thread
+
+  // UI thread only
+  std::vector<Container::Ptr> elements; // nodes of the capture in flight
+  std::vector<Container::Ptr> deferred; // left to the regular layout pass
+  std::uint64_t submittedSerial = 0;
+  std::uint64_t appliedSerial = 0;
+  std::uint64_t applied = 0;
+  sf::Vector2u lastViewport = {0, 0};
+
+  std::atomic<std::uint64_t> solvedSerial{0};
+  std::atomic<bool> stopping{false};
+  std::mutex wakeMutex;
+  std::condition_variable wake, solved;
+  std::thread worker;
+
+  bool sync(FrameBudget *budget);
+  void submit();
+  bool applyNewest();
+  // Regular layout of the deferred containers; false if out of time
+  bool layoutDeferred(FrameBudget *budget);
+  void run();
+};
@@ -0,0 +1,88 @@
+#pragma once
+#include "./element.hpp"
+#include "./element_desc.hpp"
+#include "./flex_kernel.hpp"
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Layout inputs of one element, copied out of the tree.
+ *
+ * Holds no pointer into the element tree, so a snapshot can be solved on
+ * another thread while the UI thread keeps mutating the real elements.
+ */
+struct LayoutNode {
+  StyleRef style;             // interned, so copying is a refcount bump
+  std::size_t parent = 0;     // index of the parent node (a root: itself)
+  std::size_t firstChild = 0; // children are contiguous (breadth-first)
+  std::size_t childCount = 0; // 0 if the children were not captured
+  bool flex = false; // children arranged by flexParams; otherwise deferred
+  bool measured = false; // `box` is up to date and is not measured again
+  BoxModel box;
+  WrapMode wrap = WrapMode::NoWrap;
+  FlexParams flexParams; // axis, gap, justify, align (origin/limits unused)
+};
+
+// Top of one captured subtree; its box is not changed by the solver
+struct LayoutRoot {
+  std::size_t node = 0;
+  sf::Vector2f position = {0.0f, 0.0f};
+  sf::Vector2f content = {0.0f, 0.0f}; // base of the children's % units
+  bool measure = false; // a tree root: measure it against the viewport
+};
+
+/**
+ * @brief Layout inputs of one or more subtrees of a tree.
+ *
+ * Each root's nodes follow it breadth-first, so parents always come before
+ * their children.
+ */
+struct LayoutSnapshot {
+  std::vector<LayoutNode> nodes;
+  std::vector<LayoutRoot> roots;
+  sf::Vector2u viewport = {0, 0};
+  std::uint64_t structureVersion = 0; // see Container::getStructureVersion()
+  std::uint64_t serial = 0;           // increases with every submission
+};
+
+struct NodeLayout {
+  sf::Vector2f position = {0.0f, 0.0f};
+  BoxModel box;
+  bool solved = false;   // false below a container that is not flex
+  bool arranged = false; // its children were placed by this result
+  bool root = false;     // a LayoutRoot: box and position are the inputs
+};
+
+struct LayoutResult {
+  std::vector<NodeLayout> nodes; // parallel to LayoutSnapshot::nodes
+  std::uint64_t structureVersion = 0;
+  std::uint64_t serial = 0;
+
+  // Scratch reused between solves
+  std::vector<sf::Vector2f> content, sizes, positions;
+  std::vector<WrapLine> lines;
+};
+
+/**
+ * @brief Compute boxes and positions for every node of `snapshot`.
+ *
+ * Same arithmetic as Container::layout(), but touches no element and no
+ * window, so it may run on any thread. Children of containers that do not
+ * describe a flex layout are left unsolved, as are the children of nodes
+ * whose children were not captured.
+ */
+void solveLayout(const LayoutSnapshot &snapshot, LayoutResult &result);
+
+/**
+ * @brief Layout inputs of the tree described by `root`, without elements.
+ *
+ * Same breadth-first layout as Container::captureLayout(), built from the
+ * descriptions alone, so documents can be laid out with no window at all.
+ * A node's layout inputs come from ElementDesc::describe; `descs`
+ * receives the description of each node.
+ */
+void captureLayout(const ElementDesc &root, LayoutSnapshot &snapshot,
+                   std::vector<const ElementDesc *> &descs,
+                   sf::Vector2u viewport);
@@ -0,0 +1,189 @@
+#pragma once
+#include "./element.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Lock-free queue of tree changes made from worker threads.
+ *
+ * Elements, containers and the intern pools belong to the UI thread.
+ * Workers describe their changes instead: style edits, child insertions
+ * and removals, or arbitrary tasks. The UI thread applies everything
+ * queued in one batch with drain() (Application does so once per loop
+ * iteration, before layout).
+ *
+ * The queue is a bounded multi-producer single-consumer ring: producers
+ * claim a slot with one compare-and-swap and never take a lock, so a
+ * worker can never stall the render thread. A full queue pushes back: the
+ * producer waits for the next drain (blocking mode, the default) or the
+ * push fails and returns false.
+ *
+ * Writes to the same property of the same element coalesce: only the last
+ * one queued before a drain is applied, unless an update() of that element
+ * was queued between them (it may read the earlier value). All edits of
+ * one element are
+ * folded into a single style change, i.e. one interned style and one
+ * layout invalidation per element per batch. Elements are held weakly
+ * until applied; edits of elements that died meanwhile are dropped.
+ *
+ * A worker must not touch interned values (Styles handles, id, className)
+ * itself. New children may be created on a worker and styled through the
+ * queue: style edits of a batch are applied before its insertions.
+ */
+class MutationQueue {
+public:
+  using ElementPtr = std::shared_ptr<Element>;
+  using Edit = std::function<void(Styles &)>;
+  using Task = std::function<void()>;
+
+  static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+  struct Stats {
+    std::uint64_t pushed = 0;    // mutations accepted
+    std::uint64_t full = 0;      // pushes that found the queue full
+    std::uint64_t applied = 0;   // mutations applied by drain()
+    std::uint64_t coalesced = 0; // writes superseded before being applied
+  };
+
+  // Capacity is rounded up to a power of two
+  explicit MutationQueue(std::size_t capacity = 4096);
+  ~MutationQueue();
+
+  MutationQueue(const MutationQueue &) = delete;
+  MutationQueue &operator=(const MutationQueue &) = delete;
+
+  // When full: wait for the consumer (true) or fail the push (false).
+  // Pushes from the draining thread itself never wait.
+  void setBlocking(bool blocking) { block.store(blocking); }
+
+  // -------------------------------------------------------------
+  // Producers (any thread)
+  // -------------------------------------------------------------
+
+  // Set one Styles field, e.g. queue.set(label, &Styles::width, "50%");
+  // repeated writes to the same field coalesce
+  template <typename T, typename V>
+  bool set(const ElementPtr &target, T Styles::*field, V &&value) {
+    Mutation m;
+    m.kind = Kind::Edit;
+    m.property = propertyKey(field);
+    m.target = target;
+    m.edit = [field, v = T(std::forward<V>(value))](Styles &s) {
+      s.*field = v;
+    };
+    return push(std::move(m));
+  }
+
+  // Arbitrary style edit, like Element::updateStyle (not coalesced)
+  bool update(const ElementPtr &target, Edit edit);
+
+  // Insert `child` at `position` of `container` (npos appends)
+  bool insert(const ElementPtr &container, ElementPtr child,
+              std::size_t position = npos);
+  // Remove the child of `container` with id `childId`
+  bool remove(const ElementPtr &container, std::string childId);
+
+  // Run `task` on the UI thread during the next drain
+  bool post(Task task);
+
+  // -------------------------------------------------------------
+  // Consumer (UI thread)
+  // -------------------------------------------------------------
+
+  /**
+   * @brief Apply everything queued so far; returns how many took effect.
+   *
+   * Style edits go first (one style change per element), then insertions,
+   * removals and tasks in the order they were pushed. Consecutive
+   * appends to (removals from) one container become one
+   * insertChildren (removeChildren) call. At most capacity() mutations
+   * are taken per call, so busy producers cannot starve the frame.
+   */
+  std::size_t drain();
+
+  // Nothing waiting to be drained
+  bool empty() const;
+  // Mutations accepted so far; the event loop polls while this moves
+  std::uint64_t pushCount() const {
+    return pushed.load(std::memory_order_relaxed);
+  }
+
+  std::size_t capacity() const { return mask + 1; }
+  Stats getStats() const;
+
+private:
+  enum class Kind : std::uint8_t { Edit, Insert, Remove, Task };
+
+  struct Mutation {
+    Kind kind = Kind::Task;
+    std::uintptr_t property = 0; // Edit: coalescing key, 0 = whole style
+    std::weak_ptr<Element> target;
+    ElementPtr child;            // Insert
+    std::size_t position = npos; // Insert
+    std::string id;              // Remove
+    Edit edit;
+    Task task;
+  };
+
+  struct alignas(64) Slot {
+    std::atomic<std::size_t> sequence{0};
+    Mutation mutation;
+  };
+
+  // A drained mutation with its target locked (null if gone or coalesced)
+  struct Entry {
+    Mutation mutation;
+    ElementPtr target;
+  };
+  struct PropertyHash {
+    std::size_t operator()(const std::pair<Element *, std::uintptr_t> &p) const {
+      return std::hash<Element *>()(p.first) ^ (p.second * 0x9e3779b97f4a7c15u);
+    }
+  };
+
+  std::unique_ptr<Slot[]> slots;
+  std::size_t mask = 0;
+  alignas(64) std::atomic<std::size_t> tail{0}; // next slot to claim
+  alignas(64) std::size_t head = 0;             // next slot to drain
+  std::atomic<bool> block{true};
+  std::atomic<std::thread::id> consumer{std::thread::id()};
+  std::atomic<std::uint64_t> pushed{0}, full{0};
+  std::uint64_t applied = 0, coalesced = 0;
+
+  // Drain scratch, reused between batches
+  std::vector<Entry> batch;
+  // (element, property) -> update() barriers of the element passed when
+  // the newest write was seen
+  std::unordered_map<std::pair<Element *, std::uintptr_t>, std::size_t,
+                     PropertyHash>
+      seen;
+  std::unordered_map<Element *, std::size_t> barriers;
+  std::unordered_map<Element *, std::size_t> editing;
+  std::vector<std::pair<ElementPtr, Styles>> edited;
+  std::vector<ElementPtr> run;
+  std::vector<std::string> runIds;
+
+  bool push(Mutation &&mutation);
+  bool tryPush(Mutation &mutation);
+  bool pop(Mutation &out);
+  void applyEdits();
+  void applyInOrder();
+
+  // Offset of `field` within Styles, plus one (0 means "no property")
+  template <typename T>
+  static std::uintptr_t propertyKey(T Styles::*field) {
+    static const Styles probe;
+    return static_cast<std::uintptr_t>(
+               reinterpret_cast<const char *>(&(probe.*field)) -
+               reinterpret_cast<const char *>(&probe)) +
+           1;
+  }
+};
@@ -0,0 +1,99 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <vector>
+
+class Container;
+class Renderer;
+
+/**
+ * @brief Destination of the element draw helpers.
+ *
+ * Elements normally draw straight to their window. Setting
+ * Element::backend (see renderFrame()) sends the same primitives to any
+ * other implementation instead, e.g. the software rasterizer used for
+ * headless rendering and screenshots.
+ */
+class RenderBackend {
+public:
+  virtual ~RenderBackend() = default;
+
+  // Size of the render target in pixels
+  virtual sf::Vector2u getSize() const = 0;
+
+  virtual void clear(const sf::Color &color) = 0;
+  virtual void fillRect(const sf::FloatRect &rect, const sf::Color &color) = 0;
+
+  // Outline drawn outside `rect`, like sf::Shape::setOutlineThickness
+  virtual void strokeRect(const sf::FloatRect &rect, const sf::Color &color,
+                          float thickness) = 0;
+
+  // Radii: top-left, top-right, bottom-right, bottom-left (see Util)
+  virtual void fillRoundedRect(const sf::FloatRect &rect,
+                               const sf::Color &color,
+                               const float radii[4]) = 0;
+  // Border drawn inside `rect`, like Util::drawRoundedBorder
+  virtual void strokeRoundedRect(const sf::FloatRect &rect,
+                                 const sf::Color &color, const float radii[4],
+                                 float thickness) = 0;
+
+  // Restrict drawing to `rect` (intersected with the current clip) until
+  // the matching popClip()
+  virtual void pushClip(const sf::FloatRect &rect) = 0;
+  virtual void popClip() = 0;
+
+  // Start of the overlays with absolute z-index `z` (see Renderer::flush)
+  virtual void beginLayer(int /*z*/) {}
+};
+
+/**
+ * @brief Backend drawing with SFML shapes to a window or render texture.
+ *
+ * Each instance keeps its own clip stack, so clips only nest within the
+ * backend they were pushed on; draws inside a clip must go through the
+ * same instance (see ScrollLayout::draw). Everything is skipped while the
+ * clip is empty.
+ */
+class WindowBackend : public RenderBackend {
+public:
+  explicit WindowBackend(sf::RenderTarget &target) : target(target) {}
+
+  sf::Vector2u getSize() const override { return target.getSize(); }
+
+  void clear(const sf::Color &color) override { target.clear(color); }
+  void fillRect(const sf::FloatRect &rect, const sf::Color &color) override;
+  void strokeRect(const sf::FloatRect &rect, const sf::Color &color,
+                  float thickness) override;
+  void fillRoundedRect(const sf::FloatRect &rect, const sf::Color &color,
+                       const float radii[4]) override;
+  void strokeRoundedRect(const sf::FloatRect &rect, const sf::Color &color,
+                         const float radii[4], float thickness) override;
+
+  // Clipping maps the clip rect to an sf::View covering just that area
+  void pushClip(const sf::FloatRect &rect) override;
+  void popClip() override;
+
+private:
+  struct SavedClip {
+    sf::View view;      // view to restore on pop
+    sf::FloatRect clip; // clip in effect after the push
+  };
+
+  // True while the innermost clip has no area
+  bool clippedOut() const {
+    return !clips.empty() && (clips.back().clip.width <= 0.0f ||
+                              clips.back().clip.height <= 0.0f);
+  }
+
+  sf::RenderTarget &target;
+  std::vector<SavedClip> clips;
+};
+
+/**
+ * @brief Lay out and draw one frame of `root` into `backend`.
+ *
+ * Runs the usual update, tree draw and overlay flush with Element::backend
+ * pointing at `backend`, and with viewport units resolved against the
+ * backend size instead of the window.
+ */
+void renderFrame(RenderBackend &backend, Container &root, Renderer &renderer,
+                 const sf::Color &clearColor = sf::Color::White);
@@ -24,7 +24,18 @@ public:
 
   void setRoot(Container *rootComponent);
 
+  // Ask for another frame after this one, from update() (for elements that
+  // animate themselves, e.g. a kinetic ScrollLayout)
+  void requestFrame() { frameRequested = true; }
+  // Whether a frame was requested since the last call
+  bool takeFrameRequest() {
+    const bool requested = frameRequested;
+    frameRequested = false;
+    return requested;
+  }
+
 private:
   Container *root;
   std::vector<Element *> globalDrawList;
+  bool frameRequested = false;
 };
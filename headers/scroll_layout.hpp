@@ -0,0 +1,86 @@
+#pragma once
+#include "./container.hpp"
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+
+/**
+ * @brief A flex container whose content scrolls inside its padding box.
+ *
+ * Children are laid out like in FlexLayout and may overflow; they are
+ * clipped to the padding rect (RenderBackend::pushClip, an sf::View
+ * viewport on a window). Scrolling only changes an offset applied when
+ * drawing and hit testing (getChildOffset()): it never invalidates or
+ * re-arranges anything.
+ *
+ * Without wrapping the children are ordered along the main axis, so the
+ * ones in view are found by binary search over their positions; a frame
+ * updates, draws and hit-tests only those, whatever the child count.
+ * Overlays (absZIndex >= 0) inside a child are submitted only while that
+ * child is in view, and are not clipped.
+ *
+ * The wheel and, for touches (or the mouse with dragWithMouse), dragging
+ * scroll it. Both are kinetic: the offset keeps moving with exponentially
+ * decaying velocity after a wheel notch or a released drag, advanced in
+ * update() with Renderer::requestFrame() asking for the next frame.
+ * Scroll containers nest: an event is left to the outer one once the inner
+ * one cannot move any further that way.
+ */
+template <Axis MainAxis> class ScrollLayout : public FlexLayout<MainAxis> {
+public:
+  explicit ScrollLayout(sf::RenderWindow &window);
+
+  float wheelStep = 60.0f;      // distance scrolled per wheel notch
+  float deceleration = 0.325f;  // velocity decay time constant, seconds
+  bool dragWithMouse = false;   // mouse drags scroll like touches
+
+  // Offsets are clamped to [0, getMaxScroll()]
+  void scrollTo(sf::Vector2f offset);
+  void scrollBy(sf::Vector2f delta) { scrollTo(scroll + delta); }
+  sf::Vector2f getScrollOffset() const { return clamped(scroll); }
+  sf::Vector2f getMaxScroll() const;
+
+  // Size of the scrolled content, from the last arrangement
+  sf::Vector2f getScrollExtent() const { return extent; }
+
+  // Keep scrolling with `velocity` (pixels per second), decelerating
+  void fling(sf::Vector2f velocity);
+  void stopScrolling() { velocity = {0.0f, 0.0f}; }
+  bool isScrolling() const { return velocity.x != 0.0f || velocity.y != 0.0f; }
+
+  void arrangeChildren() override;
+  void draw() override;
+  // Arranged on the UI thread even under a LayoutPipeline: arranging also
+  // measures the scroll extent
+  void describeLayout(LayoutNode & /*node*/) const override {}
+  static void describeDefaults(LayoutNode & /*node*/) {}
+
+  sf::Vector2f getChildOffset() const override { return -getScrollOffset(); }
+  bool clipsChildren() const override { return true; }
+  void childrenIn(const sf::FloatRect &area, std::size_t &first,
+                  std::size_t &last) const override;
+
+protected:
+  void updateChildren(Renderer &renderer) override;
+
+private:
+  sf::Vector2f scroll = {0.0f, 0.0f};   // may exceed the range; see clamped
+  sf::Vector2f extent = {0.0f, 0.0f};   // content size incl. padding
+  sf::Vector2f velocity = {0.0f, 0.0f}; // kinetic scrolling, pixels/second
+  sf::Clock kineticClock;
+
+  // Pointer drag
+  bool dragging = false;
+  sf::Vector2f dragLast = {0.0f, 0.0f};
+  sf::Clock dragClock;
+
+  sf::Vector2f clamped(sf::Vector2f offset) const;
+  // Area of the children in view, in layout coordinates
+  sf::FloatRect visibleArea() const;
+  // Whether scrolling by `delta` would move at all
+  bool canScroll(sf::Vector2f delta) const;
+  void onWheel(InputEvent &event);
+  void onPointer(InputEvent &event);
+};
+
+using ScrollContainer = ScrollLayout<Axis::Vertical>;
+using HorizontalScrollContainer = ScrollLayout<Axis::Horizontal>;
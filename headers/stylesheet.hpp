@@ -0,0 +1,125 @@
+#pragma once
+#include "./element.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+class Container;
+
+/**
+ * @brief Style rules matched against element type, id and className.
+ *
+ * A selector is a compound of an optional element type (template
+ * argument), an optional "#id" and any number of ".class" parts, e.g.
+ * ".card.selected" or "#header"; "*" matches everything. Declarations are
+ * edits like the ones passed to Element::updateStyle(). Matching rules
+ * apply in order of specificity (id, then classes, then type), ties in
+ * the order they were added, on top of the element's base style (the
+ * style it had when the sheet first styled it).
+ *
+ * Rules live in hash buckets keyed by their id, else their first class,
+ * else their type, so matching an element looks only at the buckets of
+ * its own id, classes and type. Resolved styles are cached per (type,
+ * class list, base style), plus the id when an id rule exists for it:
+ * identical elements share one interned style and a cache hit costs one
+ * hash lookup. Entries whose style no element uses any more are dropped
+ * by evictUnused(), which collectUnusedStyles() runs on every sheet before
+ * freeing the pools, so the cache does not keep dead styles interned.
+ *
+ * attach() styles a tree and keeps it styled: elements that join it or
+ * change their id/className are restyled; detach() puts the base styles
+ * back. Adding, editing or removing a
+ * rule restyles only the elements that rule matches, found through the
+ * tree's ElementIndex (type-only and "*" rules walk the tree).
+ */
+class Stylesheet {
+public:
+  using RuleId = std::size_t;
+  using Declarations = std::function<void(Styles &)>;
+
+  struct Stats {
+    std::uint64_t cacheHits = 0;
+    std::uint64_t cacheMisses = 0;
+    std::uint64_t restyled = 0; // elements visited by a restyle
+  };
+
+  Stylesheet();
+  ~Stylesheet();
+
+  Stylesheet(const Stylesheet &) = delete;
+  Stylesheet &operator=(const Stylesheet &) = delete;
+
+  RuleId addRule(const std::string &selector, Declarations declarations);
+  template <typename T>
+  RuleId addRule(const std::string &selector, Declarations declarations) {
+    return addRule(&typeid(T), selector, std::move(declarations));
+  }
+  void setDeclarations(RuleId rule, Declarations declarations);
+  void removeRule(RuleId rule);
+
+  // Style every element of `root`'s tree and keep them styled
+  void attach(Container &root);
+  void detach();
+
+  // Apply the matching rules to one element / a whole subtree
+  void restyle(Element &element);
+  void restyleSubtree(Element &element);
+
+  std::size_t resolvedStyles() const { return cache.size(); }
+
+  // Drop cached styles no element holds; returns how many
+  std::size_t evictUnused();
+  // evictUnused() on every live stylesheet
+  static std::size_t evictAllUnused();
+  const Stats &getStats() const { return stats; }
+
+private:
+  friend class Container; // forgets `root` when the tree is destroyed
+
+  struct Rule {
+    const std::type_info *type = nullptr;
+    InternedString id;
+    std::vector<std::string> classes;
+    int specificity = 0;
+    Declarations declarations;
+    bool live = true;
+  };
+
+  // Everything a resolved style depends on. Interned handles compare by
+  // address and keep their values alive while cached.
+  struct Key {
+    const std::type_info *type;
+    InternedString classList;
+    InternedString id; // empty unless some rule selects this id
+    StyleRef base;
+    bool operator==(const Key &o) const {
+      return type == o.type && classList == o.classList && id == o.id &&
+             base == o.base;
+    }
+  };
+  struct KeyHash {
+    std::size_t operator()(const Key &k) const;
+  };
+
+  std::vector<Rule> rules;
+  std::unordered_map<std::string, std::vector<RuleId>> byId, byClass;
+  std::unordered_map<std::type_index, std::vector<RuleId>> byType;
+  std::vector<RuleId> universal;
+
+  std::unordered_map<Key, StyleRef, KeyHash> cache;
+  std::vector<RuleId> matched; // scratch
+  Container *root = nullptr;
+  Stats stats;
+
+  RuleId addRule(const std::type_info *type, const std::string &selector,
+                 Declarations declarations);
+  bool matches(const Rule &rule, const Element &element) const;
+  const StyleRef &resolve(Element &element);
+  // Restyle the elements `rule` can match, after it changed
+  void restyleMatches(const Rule &rule);
+};
@@ -4,6 +4,19 @@
 
 namespace Util {
 
+/**
+ * @brief Fit corner radii to a rectangle.
+ *
+ * Radii are clamped to >= 0 and scaled down together (like CSS) so that
+ * adjacent corners never overlap.
+ *
+ * @param rect  The rectangle bounds.
+ * @param radii The requested radii: top-left, top-right, bottom-right,
+ * bottom-left.
+ * @param out   Receives the fitted radii.
+ */
+void fitRadii(const sf::FloatRect &rect, const float radii[4], float out[4]);
+
 /**
  * @brief Draw a rounded rectangle with individual corner radii.
  *
@@ -0,0 +1,158 @@
+// Headless zero-allocation frame check.
+//
+//   make alloc-test
+//
+// Builds a tree with flex, grid and scroll containers, renders it into a
+// SoftwareRasterizer through FrameRecorder, and fails if any frame after
+// the warm-up touches the heap. Needs the counting operator new, so the
+// target compiles everything with -DUI_ALLOC_GUARD.
+#include "../headers/alloc_guard.hpp"
+#include "../headers/draw_commands.hpp"
+#include "../headers/grid_layout.hpp"
+#include "../headers/renderer.hpp"
+#include "../headers/scroll_layout.hpp"
+#include "../headers/software_rasterizer.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+
+// The scroll offset cycles through `scrollSteps` positions; buffers reach
+// their high-water mark during the first cycle, which is the warm-up
+static const int scrollSteps = 50;
+static const int warmupFrames = scrollSteps;
+static const int frames = 4 * scrollSteps;
+
+static Container::Ptr box(sf::RenderWindow &window, int i) {
+  auto b = std::make_shared<HorizontalLayout>(window);
+  b->updateStyle([i](Styles &s) {
+    s.width = "60px";
+    s.height = "18px";
+    s.margin[0] = "2px";
+    s.backgroundColor = sf::Color(40 + i * 5 % 200, 90, 160);
+    s.borderColor = sf::Color::Black;
+    s.border[0] = "1px";
+    s.relZIndex = i % 3;
+  });
+  return b;
+}
+
+static std::shared_ptr<Container> buildTree(sf::RenderWindow &window,
+                                            ScrollContainer *&scroller) {
+  auto root = std::make_shared<VerticalLayout>(window);
+  root->updateStyle([](Styles &s) {
+    s.width = "100vw";
+    s.height = "100vh";
+    s.backgroundColor = sf::Color(235, 235, 235);
+  });
+
+  auto row = std::make_shared<HorizontalLayout>(window);
+  row->updateStyle([](Styles &s) {
+    s.width = "100%";
+    s.height = "60px";
+  });
+  row->wrap = WrapMode::Wrap;
+  row->justifyContent = JustifyContent::SpaceBetween;
+  for (int i = 0; i < 12; ++i)
+    row->addChild(box(window, i));
+  root->addChild(row);
+
+  auto grid = std::make_shared<GridLayout>(window);
+  grid->updateStyle([](Styles &s) {
+    s.width = "100%";
+    s.height = "80px";
+  });
+  grid->setColumns({"1fr", "2fr", "80px"});
+  grid->setAutoRows("20px");
+  for (int i = 0; i < 9; ++i)
+    grid->addChild(box(window, i));
+  root->addChild(grid);
+
+  auto scroll = std::make_shared<ScrollContainer>(window);
+  scroll->updateStyle([](Styles &s) {
+    s.width = "200px";
+    s.height = "120px";
+    s.backgroundColor = sf::Color::White;
+  });
+  for (int i = 0; i < 40; ++i)
+    scroll->addChild(box(window, i));
+  root->addChild(scroll);
+  scroller = scroll.get();
+
+  auto overlay = std::make_shared<VerticalLayout>(window);
+  overlay->updateStyle([](Styles &s) {
+    s.width = "30px";
+    s.height = "30px";
+    s.backgroundColor = sf::Color(0, 200, 0, 128);
+    s.absZIndex = 10;
+  });
+  root->addChild(overlay);
+  return root;
+}
+
+// The replacements must see every form of operator new. Called directly,
+// since new-expressions whose result is unused may be elided
+static bool countsEveryForm() {
+  const std::align_val_t align = static_cast<std::align_val_t>(64);
+  AllocationScope scope;
+  void *volatile p = ::operator new(16);
+  ::operator delete(p);
+  p = ::operator new[](16);
+  ::operator delete[](p);
+  p = ::operator new(16, std::nothrow);
+  ::operator delete(p, std::nothrow);
+  p = ::operator new[](16, std::nothrow);
+  ::operator delete[](p, std::nothrow);
+  p = ::operator new(16, align);
+  const bool aligned = reinterpret_cast<std::uintptr_t>(p) % 64 == 0;
+  ::operator delete(p, align);
+  p = ::operator new[](16, align);
+  ::operator delete[](p, align);
+  p = ::operator new(16, align, std::nothrow);
+  ::operator delete(p, align, std::nothrow);
+  p = ::operator new[](16, align, std::nothrow);
+  ::operator delete[](p, align, std::nothrow);
+  return aligned && scope.allocations() == 8;
+}
+
+int main() {
+  if (!AllocGuard::enabled()) {
+    std::fprintf(stderr, "alloc_frames: build with -DUI_ALLOC_GUARD\n");
+    return EXIT_FAILURE;
+  }
+  if (!countsEveryForm()) {
+    std::fprintf(stderr, "alloc_frames: an operator new form is not "
+                         "counted\n");
+    return EXIT_FAILURE;
+  }
+
+  // Nothing is drawn to the window; it only has to exist
+  sf::RenderWindow window;
+  ScrollContainer *scroller = nullptr;
+  std::shared_ptr<Container> root = buildTree(window, scroller);
+
+  SoftwareRasterizer canvas(640, 480);
+  Renderer renderer;
+  FrameRecorder recorder;
+
+  int failures = 0;
+  for (int frame = 0; frame < warmupFrames + frames; ++frame) {
+    // Offset-only changes: no layout, but a different frame every time
+    scroller->scrollTo({0.0f, static_cast<float>(frame % scrollSteps)});
+
+    AllocationScope scope;
+    recorder.present(canvas, *root, renderer, sf::Color::White, true);
+    if (frame >= warmupFrames && scope.allocations() > 0) {
+      std::fprintf(stderr, "alloc_frames: frame %d made %llu allocation(s)\n",
+                   frame,
+                   static_cast<unsigned long long>(scope.allocations()));
+      ++failures;
+    }
+  }
+
+  if (failures > 0)
+    return EXIT_FAILURE;
+  std::printf("alloc_frames: %d frames without allocations\n", frames);
+  return EXIT_SUCCESS;
+}
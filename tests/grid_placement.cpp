@@ -0,0 +1,131 @@
+// Headless GridLayout placement check.
+//
+//   make test
+//
+// Places children explicitly, by fixed row or column, with spans and by
+// auto-flow, and compares the cells GridLayout chose with the expected
+// ones. Only placement is checked; nothing is drawn.
+#include "../headers/grid_layout.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+struct Placement {
+  int column, row, columnSpan, rowSpan; // as in Styles; 0 = auto
+};
+
+struct Expected {
+  std::uint32_t column, row;
+};
+
+static std::shared_ptr<GridLayout>
+buildGrid(sf::RenderWindow &window, const std::vector<std::string> &columns,
+          const std::vector<Placement> &children) {
+  auto grid = std::make_shared<GridLayout>(window);
+  grid->updateStyle([](Styles &s) {
+    s.width = "400px";
+    s.height = "300px";
+  });
+  grid->setColumns(columns);
+  grid->setAutoRows("20px");
+  for (const Placement &p : children) {
+    auto child = std::make_shared<VerticalLayout>(window);
+    child->updateStyle([&p](Styles &s) {
+      s.width = "10px";
+      s.height = "10px";
+      s.gridColumn = p.column;
+      s.gridRow = p.row;
+      s.gridColumnSpan = p.columnSpan;
+      s.gridRowSpan = p.rowSpan;
+    });
+    grid->addChild(child);
+  }
+  grid->layout();
+  return grid;
+}
+
+static bool check(const char *name, const GridLayout &grid,
+                  const std::vector<Expected> &expected,
+                  std::size_t columnCount) {
+  bool ok = true;
+  const std::vector<GridLayout::Cell> &cells = grid.getCells();
+  for (std::size_t i = 0; i < expected.size(); ++i) {
+    if (cells[i].column != expected[i].column ||
+        cells[i].row != expected[i].row) {
+      std::fprintf(stderr,
+                   "grid_placement: %s: child %zu at (%u, %u), expected "
+                   "(%u, %u)\n",
+                   name, i, cells[i].column, cells[i].row, expected[i].column,
+                   expected[i].row);
+      ok = false;
+    }
+  }
+  if (grid.getColumnSizes().size() != columnCount) {
+    std::fprintf(stderr, "grid_placement: %s: %zu columns, expected %zu\n",
+                 name, grid.getColumnSizes().size(), columnCount);
+    ok = false;
+  }
+  return ok;
+}
+
+int main() {
+  sf::RenderWindow window;
+  bool ok = true;
+
+  // Explicit cells first, then auto-flow around them; an auto span that
+  // does not fit wraps, a fixed column scans down from its first free row
+  {
+    auto grid = buildGrid(window, {"100px", "1fr", "2fr"},
+                          {{0, 0, 1, 1},
+                           {3, 1, 1, 1},
+                           {0, 0, 2, 1},
+                           {0, 0, 1, 1},
+                           {2, 0, 1, 1},
+                           {0, 0, 3, 1}});
+    ok &= check("mixed", *grid,
+                {{0, 0}, {2, 0}, {0, 1}, {2, 1}, {1, 0}, {0, 2}}, 3);
+  }
+
+  // Explicit cells that overlap auto-flow rows and span two rows
+  {
+    auto grid = buildGrid(window, {"1fr", "1fr"},
+                          {{2, 1, 1, 2}, {0, 0, 1, 1}, {0, 0, 1, 1},
+                           {0, 0, 1, 1}});
+    ok &= check("row spans", *grid, {{1, 0}, {0, 0}, {0, 1}, {0, 2}}, 2);
+  }
+
+  // A row with no room left gets implicit columns instead of overlapping
+  {
+    auto grid = buildGrid(window, {"50px", "50px"},
+                          {{0, 1, 1, 1}, {0, 1, 1, 1}, {0, 1, 1, 1},
+                           {0, 1, 2, 1}});
+    ok &= check("fixed row overflow", *grid,
+                {{0, 0}, {1, 0}, {2, 0}, {3, 0}}, 5);
+  }
+
+  // Fixed rows leave occupied cells to auto-flow, which continues after
+  {
+    auto grid = buildGrid(window, {"1fr", "1fr", "1fr"},
+                          {{0, 0, 1, 1}, {0, 2, 2, 1}, {0, 1, 1, 1},
+                           {0, 0, 1, 1}, {0, 0, 1, 1}});
+    ok &= check("fixed rows", *grid,
+                {{1, 0}, {0, 1}, {0, 0}, {2, 0}, {2, 1}}, 3);
+  }
+
+  // Many children pinned to one row land side by side, in child order
+  {
+    const std::size_t count = 2000;
+    std::vector<Placement> pinned(count, Placement{0, 1, 1, 1});
+    std::vector<Expected> expected;
+    for (std::uint32_t i = 0; i < count; ++i)
+      expected.push_back({i, 0});
+    auto grid = buildGrid(window, {"1fr"}, pinned);
+    ok &= check("pinned row", *grid, expected, count);
+  }
+
+  if (!ok)
+    return EXIT_FAILURE;
+  std::printf("grid_placement: ok\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,119 @@
+// Headless MutationQueue check.
+//
+//   make test
+//
+// Queues style writes around update() edits and checks what drain()
+// applies: repeated set() writes of one field coalesce, but never across
+// an update() of the same element, which may read the older value. Also
+// checks that writes from several threads all arrive or are superseded.
+#include "../headers/container.hpp"
+#include "../headers/mutation_queue.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+static bool check(const char *what, bool ok) {
+  if (!ok)
+    std::fprintf(stderr, "mutation_coalescing: %s\n", what);
+  return ok;
+}
+
+int main() {
+  sf::RenderWindow window;
+  bool ok = true;
+
+  auto root = std::make_shared<VerticalLayout>(window);
+  auto bar = std::make_shared<HorizontalLayout>(window);
+  auto other = std::make_shared<HorizontalLayout>(window);
+  root->addChild(bar);
+  root->addChild(other);
+
+  // Writes with nothing in between coalesce into the last one
+  {
+    MutationQueue queue;
+    for (int i = 0; i < 10; ++i)
+      queue.set(bar, &Styles::width, std::to_string(i) + "px");
+    queue.set(bar, &Styles::height, std::string("5px"));
+    const std::size_t applied = queue.drain();
+    ok &= check("repeated writes coalesce",
+                applied == 2 && queue.getStats().coalesced == 9);
+    ok &= check("the last write wins", bar->style->width == "9px" &&
+                                           bar->style->height == "5px");
+  }
+
+  // An update() reads the write queued before it, not the later one
+  {
+    MutationQueue queue;
+    queue.set(bar, &Styles::width, std::string("10px"));
+    queue.update(bar, [](Styles &s) { s.height = s.width; });
+    queue.set(bar, &Styles::width, std::string("20px"));
+    queue.drain();
+    ok &= check("writes do not coalesce across an update()",
+                queue.getStats().coalesced == 0);
+    ok &= check("update() sees the write queued before it",
+                bar->style->width == "20px" && bar->style->height == "10px");
+  }
+
+  // Each side of the barrier still coalesces on its own
+  {
+    MutationQueue queue;
+    queue.set(bar, &Styles::width, std::string("1px"));
+    queue.set(bar, &Styles::width, std::string("2px"));
+    queue.set(bar, &Styles::width, std::string("3px"));
+    queue.update(bar, [](Styles &s) { s.height = s.width; });
+    queue.set(bar, &Styles::width, std::string("4px"));
+    queue.set(bar, &Styles::width, std::string("5px"));
+    queue.drain();
+    ok &= check("writes coalesce on each side of an update()",
+                queue.getStats().coalesced == 3);
+    ok &= check("coalesced writes around an update() apply in order",
+                bar->style->width == "5px" && bar->style->height == "3px");
+  }
+
+  // An update() of another element is no barrier
+  {
+    MutationQueue queue;
+    queue.set(bar, &Styles::width, std::string("6px"));
+    queue.update(other, [](Styles &s) { s.height = "1px"; });
+    queue.set(bar, &Styles::width, std::string("7px"));
+    queue.drain();
+    ok &= check("an update() of another element does not split writes",
+                queue.getStats().coalesced == 1 &&
+                    bar->style->width == "7px");
+  }
+
+  // Several producers: every push is applied or superseded
+  {
+    MutationQueue queue(256);
+    const int threads = 4, writes = 20000;
+    std::atomic<int> running{threads};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+      workers.emplace_back([&]() {
+        for (int i = 0; i < writes; ++i)
+          queue.set(bar, &Styles::width, std::to_string(i) + "px");
+        --running;
+      });
+    }
+    while (running > 0 || !queue.empty())
+      queue.drain();
+    for (std::thread &worker : workers)
+      worker.join();
+    const MutationQueue::Stats &stats = queue.getStats();
+    ok &= check("every push is applied or coalesced",
+                stats.pushed == static_cast<std::uint64_t>(threads * writes) &&
+                    stats.applied + stats.coalesced == stats.pushed);
+    ok &= check("the last write of the last batch wins",
+                bar->style->width == std::to_string(writes - 1) + "px");
+  }
+
+  if (!ok)
+    return EXIT_FAILURE;
+  std::printf("mutation_coalescing: ok\n");
+  return EXIT_SUCCESS;
+}
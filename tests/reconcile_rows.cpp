@@ -0,0 +1,138 @@
+// Headless Container::reconcile check.
+//
+//   make test
+//
+// Reconciles a 10k-row table against edited descriptions. Changing one row
+// must restyle exactly that row; a swap, a move, an insert and a removal
+// must report the minimal number of moves. After each edit the layout
+// must equal the one of a fresh build.
+#include "../headers/container.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct Row {
+  std::string key;
+  int height;
+};
+
+static StyleRef rowStyle(int height) {
+  Styles s;
+  s.width = "100%";
+  s.height = std::to_string(height) + "px";
+  return StyleRef(s);
+}
+
+static std::vector<ElementDesc> describe(const std::vector<Row> &rows) {
+  Styles cell;
+  cell.width = "30px";
+  cell.height = "100%";
+  const StyleRef cellStyle(cell);
+
+  std::vector<ElementDesc> out;
+  out.reserve(rows.size());
+  for (const Row &row : rows) {
+    std::vector<ElementDesc> cells;
+    for (int c = 0; c < 3; ++c)
+      cells.push_back(ElementDesc::of<VerticalLayout>("", cellStyle));
+    out.push_back(ElementDesc::of<HorizontalLayout>(
+        row.key, rowStyle(row.height), std::move(cells)));
+  }
+  return out;
+}
+
+static std::shared_ptr<Container> makeRoot(sf::RenderWindow &window) {
+  auto root = std::make_shared<VerticalLayout>(window);
+  root->updateStyle([](Styles &s) {
+    s.width = "400px";
+    s.height = "200000px";
+  });
+  return root;
+}
+
+// Position and size of every element, depth first
+static void boxes(const Element &element, std::vector<float> &out) {
+  out.push_back(element.computedPosition.x);
+  out.push_back(element.computedPosition.y);
+  out.push_back(element.boxModel.computedSize.x);
+  out.push_back(element.boxModel.computedSize.y);
+  if (auto *container = dynamic_cast<const Container *>(&element))
+    for (const auto &child : container->getChildren())
+      boxes(*child, out);
+}
+
+static bool matchesFreshBuild(sf::RenderWindow &window, Container &root,
+                              const std::vector<Row> &rows) {
+  auto fresh = makeRoot(window);
+  fresh->reconcile(describe(rows));
+  fresh->layout();
+  root.layout();
+  std::vector<float> expected, actual;
+  boxes(*fresh, expected);
+  boxes(root, actual);
+  return actual == expected;
+}
+
+static bool check(const char *what, bool ok) {
+  if (!ok)
+    std::fprintf(stderr, "reconcile_rows: %s\n", what);
+  return ok;
+}
+
+int main() {
+  sf::RenderWindow window;
+  bool ok = true;
+
+  std::vector<Row> rows;
+  for (int i = 0; i < 10000; ++i)
+    rows.push_back({"r" + std::to_string(i), 10 + i % 5});
+  auto root = makeRoot(window);
+  ReconcileStats stats = root->reconcile(describe(rows));
+  ok &= check("initial build creates 4 elements per row",
+              stats.created == 40000);
+  root->layout();
+
+  // One changed row: one restyle, nothing built, removed or moved
+  const Element *kept = root->getChildren()[5000].get();
+  rows[5000].height = 40;
+  stats = root->reconcile(describe(rows));
+  ok &= check("one changed row restyles exactly one element",
+              stats.restyled == 1 && stats.created == 0 &&
+                  stats.removed == 0 && stats.moved == 0);
+  ok &= check("the changed row keeps its element",
+              root->getChildren()[5000].get() == kept);
+  ok &= check("rows before the change keep their layout",
+              !root->getChildren()[4999]->needsLayout());
+  ok &= check("layout after one change equals a fresh build",
+              matchesFreshBuild(window, *root, rows));
+
+  // Swap two rows, move one by 50, insert two and remove one: a swap needs
+  // two moves and the single move one
+  std::swap(rows[10], rows[9000]);
+  rows.erase(rows.begin() + 200);
+  rows.insert(rows.begin() + 300, {"new", 12});
+  rows.push_back({"tail", 11});
+  std::rotate(rows.begin() + 100, rows.begin() + 101, rows.begin() + 151);
+  stats = root->reconcile(describe(rows));
+  ok &= check("edits report the minimal number of moves",
+              stats.moved == 3);
+  ok &= check("edits create the new rows and remove the dropped one",
+              stats.created == 8 && stats.removed == 1);
+  for (std::size_t i = 0; i < rows.size(); ++i) {
+    const Element &child = *root->getChildren()[i];
+    if (child.getId() != rows[i].key || child.getIndexInParent() != i) {
+      ok &= check("children follow the description order", false);
+      break;
+    }
+  }
+  ok &= check("layout after the edits equals a fresh build",
+              matchesFreshBuild(window, *root, rows));
+
+  if (!ok)
+    return EXIT_FAILURE;
+  std::printf("reconcile_rows: ok\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,120 @@
+// Headless Stylesheet check.
+//
+//   make test
+//
+// Attaches a stylesheet to 1000 rows and edits its rules. Every rule edit
+// must restyle only the elements that rule matches, the others keeping
+// their resolved style; resolved styles nobody uses any more must be
+// dropped by collectUnusedStyles().
+#include "../headers/container.hpp"
+#include "../headers/stylesheet.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+static bool check(const char *what, bool ok) {
+  if (!ok)
+    std::fprintf(stderr, "stylesheet_matches: %s\n", what);
+  return ok;
+}
+
+int main() {
+  sf::RenderWindow window;
+  bool ok = true;
+
+  auto root = std::make_shared<VerticalLayout>(window);
+  root->updateStyle([](Styles &s) {
+    s.width = "400px";
+    s.height = "20000px";
+  });
+  std::vector<std::shared_ptr<Element>> rows;
+  for (int i = 0; i < 1000; ++i) {
+    auto row = std::make_shared<HorizontalLayout>(window);
+    row->updateStyle([](Styles &s) {
+      s.width = "100%";
+      s.height = "10px";
+    });
+    row->setClassName(i % 2 ? "row odd" : "row");
+    if (i == 7)
+      row->setId("seven");
+    root->addChild(row);
+    rows.push_back(row);
+  }
+
+  Stylesheet sheet;
+  const Stylesheet::RuleId rowRule =
+      sheet.addRule(".row", [](Styles &s) { s.height = "20px"; });
+  const Stylesheet::RuleId oddRule =
+      sheet.addRule(".odd", [](Styles &s) { s.relZIndex = 5; });
+  sheet.attach(*root);
+  ok &= check("rules apply on attach", rows[0]->style->height == "20px" &&
+                                           rows[1]->style->relZIndex == 5 &&
+                                           rows[0]->style->relZIndex == 0);
+  ok &= check("equal elements share one resolved style",
+              rows[2]->style == rows[4]->style);
+
+  // Visits of each edit, and whether the even rows kept their style
+  std::uint64_t visited = sheet.getStats().restyled;
+  auto restyledSince = [&]() {
+    const std::uint64_t now = sheet.getStats().restyled;
+    const std::uint64_t count = now - visited;
+    visited = now;
+    return count;
+  };
+  const StyleRef evenStyle = rows[0]->style;
+
+  sheet.addRule("#seven", [](Styles &s) { s.height = "99px"; });
+  ok &= check("an id rule restyles only its element", restyledSince() == 1);
+  ok &= check("id rules beat class rules", rows[7]->style->height == "99px");
+
+  sheet.addRule(".odd.row", [](Styles &s) { s.height = "33px"; });
+  ok &= check("a new rule restyles only its matches", restyledSince() == 500);
+  ok &= check("a new rule applies", rows[1]->style->height == "33px" &&
+                                        rows[7]->style->height == "99px");
+  ok &= check("non-matching rows keep their style",
+              rows[0]->style == evenStyle);
+
+  sheet.setDeclarations(oddRule, [](Styles &s) { s.relZIndex = 6; });
+  ok &= check("editing a rule restyles only its matches",
+              restyledSince() == 500 && rows[1]->style->relZIndex == 6 &&
+                  rows[0]->style == evenStyle);
+
+  rows[0]->setClassName("row odd");
+  ok &= check("a class change restyles only that element",
+              restyledSince() == 1 && rows[0]->style->height == "33px");
+
+  sheet.removeRule(rowRule);
+  ok &= check("removing a rule restyles only its matches",
+              restyledSince() == 1000 && rows[2]->style->height == "10px");
+
+  // Resolutions of removed rows are only kept alive by the cache
+  const std::size_t cached = sheet.resolvedStyles();
+  for (int i = 0; i < 100; ++i) {
+    auto row = std::make_shared<HorizontalLayout>(window);
+    row->setClassName("row odd");
+    row->updateStyle([i](Styles &s) { s.width = std::to_string(i) + "px"; });
+    root->addChild(row);
+  }
+  ok &= check("distinct base styles are cached",
+              sheet.resolvedStyles() >= cached + 100);
+  root->clearChildren();
+  root->addChild(rows[0]);
+  collectUnusedStyles();
+  ok &= check("unused resolved styles are evicted",
+              sheet.resolvedStyles() <= cached);
+  ok &= check("styles in use survive eviction",
+              rows[0]->style->height == "33px");
+
+  sheet.detach();
+  ok &= check("detach restores the base styles",
+              rows[0]->style->height == "10px" &&
+                  rows[0]->style->relZIndex == 0);
+
+  if (!ok)
+    return EXIT_FAILURE;
+  std::printf("stylesheet_matches: ok\n");
+  return EXIT_SUCCESS;
+}